@@ -0,0 +1,185 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+// Bytes currently held by all TBenchAllocator instances. Benchmarks read it
+// right after building a container to report bytes per element.
+inline size_t& BenchLiveBytes()
+{
+  static size_t bytes = 0;
+  return bytes;
+}
+
+// Heap bytes behind an allocation of n bytes at p. Under glibc that is the
+// chunk: its usable size plus the size word in front of it, so 16- and
+// 24-byte requests both count as 32. Elsewhere the request itself.
+inline size_t BenchHeldBytes(void* p, size_t n)
+{
+#if defined(__GLIBC__)
+  (void)n;
+  return malloc_usable_size(p) + sizeof(size_t);
+#else
+  (void)p;
+  return n;
+#endif
+}
+
+// std::allocator that keeps BenchLiveBytes() up to date.
+template <class T>
+struct TBenchAllocator
+{
+  using value_type = T;
+
+  TBenchAllocator() = default;
+  template <class U>
+  TBenchAllocator(const TBenchAllocator<U>&) {}
+
+  T* allocate(size_t n)
+  {
+    T* p = std::allocator<T>().allocate(n);
+    BenchLiveBytes() += BenchHeldBytes(p, n * sizeof(T));
+    return p;
+  }
+
+  void deallocate(T* p, size_t n)
+  {
+    BenchLiveBytes() -= BenchHeldBytes(p, n * sizeof(T));
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  template <class U>
+  bool operator==(const TBenchAllocator<U>&) const { return true; }
+  template <class U>
+  bool operator!=(const TBenchAllocator<U>&) const { return false; }
+};
+
+class TBenchTimer
+{
+public:
+  TBenchTimer() : start(std::chrono::steady_clock::now()) {}
+
+  double ElapsedNs() const
+  {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  }
+
+private:
+  std::chrono::steady_clock::time_point start;
+};
+
+// Keeps results alive so the optimiser cannot drop the measured loops: the
+// empty asm claims to read v, so everything that computed it has to run.
+inline void BenchSink(size_t v)
+{
+#if defined(__GNUC__)
+  asm volatile("" : : "r"(v) : "memory");
+#else
+  static volatile size_t sink;
+  sink = v;
+  (void)sink;
+#endif
+}
+
+// One line of output: ns per operation and, when known, container memory
+// per element (0 if not measured).
+struct TBenchRow
+{
+  std::string bench;
+  std::string container;
+  size_t size;
+  double nsPerOp;
+  double bytesPerElem;
+};
+
+// Collects rows and prints them as CSV so runs can be diffed and plotted.
+class TBenchReport
+{
+public:
+  void Add(const std::string& bench, const std::string& container, size_t size, double nsPerOp,
+           double bytesPerElem = 0)
+  {
+    rows.push_back(TBenchRow{ bench, container, size, nsPerOp, bytesPerElem });
+  }
+
+  void Print(std::ostream& os) const
+  {
+    os << "bench,container,size,ns_per_op,bytes_per_elem\n";
+    for (const TBenchRow& r : rows)
+      os << r.bench << ',' << r.container << ',' << r.size << ',' << r.nsPerOp << ',' << r.bytesPerElem << '\n';
+  }
+
+private:
+  std::vector<TBenchRow> rows;
+};
+
+// Runs a measurement a few times and keeps the fastest, which is the least
+// disturbed by the rest of the machine. run() returns elapsed nanoseconds.
+template <class F>
+double BenchBestOf(size_t n, F&& run)
+{
+  int reps = n <= 1000 ? 50 : n <= 100000 ? 5 : 2;
+  double best = run();
+  for (int i = 1; i < reps; i++)
+  {
+    double t = run();
+    if (t < best)
+      best = t;
+  }
+  return best;
+}
+
+// Generic benchmarks usable with any container offering push_back and
+// forward iteration. Containers should use TBenchAllocator for the memory
+// column to be meaningful.
+template <class L>
+void BenchPushBack(TBenchReport& report, const std::string& name, size_t n)
+{
+  double bytes = 0;
+  double ns = BenchBestOf(n, [&]() {
+    L l;
+    size_t before = BenchLiveBytes();
+    TBenchTimer t;
+    for (size_t i = 0; i < n; i++)
+      l.push_back(static_cast<typename L::value_type>(i));
+    double e = t.ElapsedNs();
+    bytes = double(BenchLiveBytes() - before) / double(n);
+    return e;
+  });
+  report.Add("push_back", name, n, ns / double(n), bytes);
+}
+
+template <class L>
+void BenchTraversal(TBenchReport& report, const std::string& name, size_t n)
+{
+  L l;
+  for (size_t i = 0; i < n; i++)
+    l.push_back(static_cast<typename L::value_type>(i));
+  double ns = BenchBestOf(n, [&]() {
+    TBenchTimer t;
+    size_t sum = 0;
+    for (const auto& v : l)
+      sum += static_cast<size_t>(v);
+    double e = t.ElapsedNs();
+    BenchSink(sum);
+    return e;
+  });
+  report.Add("traversal", name, n, ns / double(n));
+}
+
+// Entry points of the individual benchmark sources.
+void BenchContainers(TBenchReport& report, const std::vector<size_t>& sizes);
+void BenchUnrolled(TBenchReport& report, const std::vector<size_t>& sizes);
+void BenchSort(TBenchReport& report, const std::vector<size_t>& sizes);
+void BenchMpsc(TBenchReport& report, const std::vector<size_t>& sizes);
+void BenchSets(TBenchReport& report, const std::vector<size_t>& sizes);
+void BenchParallel(TBenchReport& report, const std::vector<size_t>& sizes);
+void BenchIndexed(TBenchReport& report, const std::vector<size_t>& sizes);
+void BenchLru(TBenchReport& report, const std::vector<size_t>& sizes);
+void BenchSmall(TBenchReport& report, const std::vector<size_t>& sizes);
@@ -0,0 +1,175 @@
+#include "bench.h"
+#include "tlist.h"
+
+#include <algorithm>
+#include <functional>
+#include <list>
+#include <numeric>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+  using TBenchIndexed = TIndexedList<int, std::hash<int>, std::equal_to<int>, TBenchAllocator<int>>;
+
+  // The usual hand-rolled linked hash set: a std::list for order and an
+  // unordered_map from key to list node.
+  class TMapAndList
+  {
+  public:
+    using value_type = int;
+
+    bool push_back(int v)
+    {
+      if (index.count(v) != 0)
+        return false;
+      items.push_back(v);
+      index.emplace(v, std::prev(items.end()));
+      return true;
+    }
+
+    bool contains(int v) const { return index.count(v) != 0; }
+
+    size_t erase(int v)
+    {
+      auto it = index.find(v);
+      if (it == index.end())
+        return 0;
+      items.erase(it->second);
+      index.erase(it);
+      return 1;
+    }
+
+  private:
+    using TItems = std::list<int, TBenchAllocator<int>>;
+    TItems items;
+    std::unordered_map<int, TItems::iterator, std::hash<int>, std::equal_to<int>,
+                       TBenchAllocator<std::pair<const int, TItems::iterator>>>
+      index;
+  };
+
+  // What TIndexedList replaces: a plain TList searched front to back.
+  class TScannedList
+  {
+  public:
+    using value_type = int;
+
+    bool push_back(int v)
+    {
+      if (contains(v))
+        return false;
+      items.push_back(v);
+      return true;
+    }
+
+    bool contains(int v) const { return std::find(items.begin(), items.end(), v) != items.end(); }
+
+    size_t erase(int v)
+    {
+      auto it = std::find(items.begin(), items.end(), v);
+      if (it == items.end())
+        return 0;
+      items.erase(it);
+      return 1;
+    }
+
+  private:
+    TList<int, TBenchAllocator<int>> items;
+  };
+
+  // Linear search is only run up to this size.
+  const size_t ScanLimit = 10000;
+
+  // Lookups timed per size; half of them miss.
+  const size_t LookupOps = 100000;
+
+  std::vector<int> Shuffled(size_t n, unsigned seed)
+  {
+    std::vector<int> keys(n);
+    std::iota(keys.begin(), keys.end(), 0);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(seed));
+    return keys;
+  }
+
+  // Builds the set from n distinct keys in random order, each pushed twice
+  // so half of the inserts are rejected duplicates.
+  template <class S>
+  void Build(TBenchReport& report, const char* name, size_t n)
+  {
+    std::vector<int> keys = Shuffled(n, 1);
+    double bytes = 0;
+    double ns = BenchBestOf(n, [&]() {
+      S s;
+      size_t before = BenchLiveBytes();
+      TBenchTimer t;
+      for (int k : keys)
+      {
+        s.push_back(k);
+        s.push_back(k);
+      }
+      double e = t.ElapsedNs();
+      bytes = double(BenchLiveBytes() - before) / double(n);
+      return e;
+    });
+    report.Add("dedup_build", name, n, ns / double(2 * n), bytes);
+  }
+
+  template <class S>
+  void Lookup(TBenchReport& report, const char* name, size_t n)
+  {
+    S s;
+    for (size_t i = 0; i < n; i++)
+      s.push_back(int(i));
+    std::mt19937 rng(2);
+    std::uniform_int_distribution<int> key(0, int(2 * n - 1));
+    std::vector<int> probes(LookupOps);
+    for (int& p : probes)
+      p = key(rng);
+    double ns = BenchBestOf(n, [&]() {
+      TBenchTimer t;
+      size_t hits = 0;
+      for (int p : probes)
+        hits += s.contains(p);
+      double e = t.ElapsedNs();
+      BenchSink(hits);
+      return e;
+    });
+    report.Add("contains", name, n, ns / double(LookupOps));
+  }
+
+  template <class S>
+  void EraseByValue(TBenchReport& report, const char* name, size_t n)
+  {
+    std::vector<int> keys = Shuffled(n, 3);
+    double ns = BenchBestOf(n, [&]() {
+      S s;
+      for (size_t i = 0; i < n; i++)
+        s.push_back(int(i));
+      TBenchTimer t;
+      for (int k : keys)
+        s.erase(k);
+      return t.ElapsedNs();
+    });
+    report.Add("erase_value", name, n, ns / double(n));
+  }
+
+  template <class S>
+  void RunAll(TBenchReport& report, const char* name, size_t n)
+  {
+    Build<S>(report, name, n);
+    Lookup<S>(report, name, n);
+    EraseByValue<S>(report, name, n);
+  }
+}
+
+void BenchIndexed(TBenchReport& report, const std::vector<size_t>& sizes)
+{
+  for (size_t n : sizes)
+  {
+    RunAll<TBenchIndexed>(report, "TIndexedList", n);
+    RunAll<TMapAndList>(report, "unordered_map+std::list", n);
+    if (n <= ScanLimit)
+      RunAll<TScannedList>(report, "TList+find", n);
+  }
+}
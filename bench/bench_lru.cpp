@@ -0,0 +1,119 @@
+#include "bench.h"
+#include "tlru.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <list>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace
+{
+  using TBenchLru = TLruCache<int, int, std::hash<int>, std::equal_to<int>, TLruSizeofWeight,
+                              TBenchAllocator<std::pair<const int, int>>>;
+
+  // The LRU most services write by hand: std::list of pairs plus an
+  // unordered_map into it.
+  class TStdLru
+  {
+  public:
+    explicit TStdLru(size_t capacity) : capacity(capacity) {}
+
+    int* get(int k)
+    {
+      auto it = index.find(k);
+      if (it == index.end())
+        return nullptr;
+      items.splice(items.begin(), items, it->second);
+      return &it->second->second;
+    }
+
+    void put(int k, int v)
+    {
+      auto it = index.find(k);
+      if (it != index.end())
+      {
+        it->second->second = v;
+        items.splice(items.begin(), items, it->second);
+        return;
+      }
+      items.emplace_front(k, v);
+      index.emplace(k, items.begin());
+      if (items.size() > capacity)
+      {
+        index.erase(items.back().first);
+        items.pop_back();
+      }
+    }
+
+  private:
+    using TItems = std::list<std::pair<int, int>, TBenchAllocator<std::pair<int, int>>>;
+    size_t capacity;
+    TItems items;
+    std::unordered_map<int, TItems::iterator, std::hash<int>, std::equal_to<int>,
+                       TBenchAllocator<std::pair<const int, TItems::iterator>>>
+      index;
+  };
+
+  const size_t OpsPerRun = 200000;
+
+  // Keys in [0, n) drawn with probability proportional to 1/(rank+1)^s and
+  // scattered so hot keys are not numerically adjacent.
+  std::vector<int> ZipfKeys(size_t n, size_t count, double s)
+  {
+    std::vector<double> cdf(n);
+    double sum = 0;
+    for (size_t i = 0; i < n; i++)
+      cdf[i] = sum += 1.0 / std::pow(double(i + 1), s);
+    std::vector<int> perm(n);
+    for (size_t i = 0; i < n; i++)
+      perm[i] = int(i);
+    std::mt19937 rng(7);
+    std::shuffle(perm.begin(), perm.end(), rng);
+    std::uniform_real_distribution<double> u(0, sum);
+    std::vector<int> keys(count);
+    for (int& k : keys)
+      k = perm[std::lower_bound(cdf.begin(), cdf.end(), u(rng)) - cdf.begin()];
+    return keys;
+  }
+
+  // Read-through workload: get, and put on a miss. The cache holds a tenth
+  // of the key space. Reports ns per lookup and bytes per cached entry.
+  template <class C>
+  void ReadThrough(TBenchReport& report, const char* name, size_t n, const std::vector<int>& keys)
+  {
+    size_t capacity = std::max<size_t>(1, n / 10);
+    double bytes = 0;
+    double ns = BenchBestOf(OpsPerRun, [&]() {
+      size_t before = BenchLiveBytes();
+      C c(capacity);
+      TBenchTimer t;
+      size_t hits = 0;
+      for (int k : keys)
+      {
+        if (int* v = c.get(k))
+          hits += size_t(*v == k);
+        else
+          c.put(k, k);
+      }
+      double e = t.ElapsedNs();
+      bytes = double(BenchLiveBytes() - before) / double(capacity);
+      BenchSink(hits);
+      return e;
+    });
+    report.Add("lru_zipf", name, n, ns / double(keys.size()), bytes);
+  }
+}
+
+void BenchLru(TBenchReport& report, const std::vector<size_t>& sizes)
+{
+  for (size_t n : sizes)
+  {
+    std::vector<int> keys = ZipfKeys(n, OpsPerRun, 0.99);
+    ReadThrough<TBenchLru>(report, "TLruCache", n, keys);
+    ReadThrough<TStdLru>(report, "unordered_map+std::list", n, keys);
+  }
+}
@@ -0,0 +1,45 @@
+#include "bench.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+  struct TSuite
+  {
+    const char* name;
+    void (*run)(TBenchReport&, const std::vector<size_t>&);
+  };
+
+  const TSuite Suites[] = {
+    { "containers", BenchContainers },
+    { "unrolled", BenchUnrolled },
+    { "sort", BenchSort },
+    { "mpsc", BenchMpsc },
+    { "sets", BenchSets },
+    { "parallel", BenchParallel },
+    { "indexed", BenchIndexed },
+    { "lru", BenchLru },
+    { "small", BenchSmall },
+  };
+}
+
+// Usage: bench_tlist [max_size] [suite]
+// Sizes run from 10 up to max_size (default 10^7) in powers of ten. suite
+// restricts the run to one of the suites above. The report goes to stdout
+// as CSV: bench,container,size,ns_per_op,bytes_per_elem.
+int main(int argc, char **argv)
+{
+  size_t maxSize = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+  const char* only = argc > 2 ? argv[2] : nullptr;
+  std::vector<size_t> sizes;
+  for (size_t n = 10; n <= maxSize; n *= 10)
+    sizes.push_back(n);
+
+  TBenchReport report;
+  for (const TSuite& s : Suites)
+    if (only == nullptr || std::strcmp(only, s.name) == 0)
+      s.run(report, sizes);
+  report.Print(std::cout);
+  return 0;
+}
@@ -0,0 +1,81 @@
+#include "bench.h"
+#include "tlist.h"
+
+#include <mutex>
+#include <thread>
+
+namespace
+{
+  // TList behind one mutex, the baseline TMpscList replaces.
+  class TLockedQueue
+  {
+  public:
+    void push(size_t v)
+    {
+      std::lock_guard<std::mutex> lock(m);
+      l.push_back(v);
+    }
+
+    bool try_pop(size_t& v)
+    {
+      std::lock_guard<std::mutex> lock(m);
+      if (l.empty())
+        return false;
+      v = l.front();
+      l.pop_front();
+      return true;
+    }
+
+  private:
+    std::mutex m;
+    TList<size_t> l;
+  };
+
+  // n items spread over the producers, drained by the calling thread.
+  template <class Q>
+  double RunQueue(size_t producers, size_t n)
+  {
+    Q q;
+    size_t perProducer = n / producers;
+    std::vector<std::thread> threads;
+    TBenchTimer t;
+    for (size_t p = 0; p < producers; p++)
+      threads.emplace_back([&q, perProducer]() {
+        for (size_t i = 0; i < perProducer; i++)
+          q.push(i);
+      });
+    size_t received = 0;
+    size_t sum = 0;
+    size_t v;
+    while (received < perProducer * producers)
+      if (q.try_pop(v))
+      {
+        sum += v;
+        received++;
+      }
+      else
+        std::this_thread::yield();
+    double e = t.ElapsedNs();
+    for (auto& th : threads)
+      th.join();
+    BenchSink(sum);
+    return e / double(received);
+  }
+}
+
+// Throughput of one consumer fed by 1..16 producers: TMpscList against a
+// mutex-guarded TList. Reported per transferred element.
+void BenchMpsc(TBenchReport& report, const std::vector<size_t>& sizes)
+{
+  for (size_t n : sizes)
+  {
+    if (n < 1000 || n > 1000000)
+      continue;
+    for (size_t producers = 1; producers <= 16; producers *= 2)
+    {
+      std::string bench = "mpsc_p" + std::to_string(producers);
+      report.Add(bench, "TMpscList", n, BenchBestOf(n, [&]() { return RunQueue<TMpscList<size_t>>(producers, n); }));
+      report.Add(bench, "mutex+TList", n, BenchBestOf(n, [&]() { return RunQueue<TLockedQueue>(producers, n); }));
+    }
+  }
+}
@@ -0,0 +1,56 @@
+#include "bench.h"
+#include "tlist.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace
+{
+  // A few dozen dependent multiply-xorshift rounds: enough work per element
+  // that the walk itself is not the bottleneck.
+  size_t Work(size_t x)
+  {
+    for (int i = 0; i < 32; i++)
+    {
+      x ^= x >> 29;
+      x *= 0xbf58476d1ce4e5b9ull;
+    }
+    return x;
+  }
+}
+
+// Scaling of tlist::parallel_for_each and parallel_transform from one
+// thread to every hardware thread on a CPU-bound per-element function.
+// Reported per element.
+void BenchParallel(TBenchReport& report, const std::vector<size_t>& sizes)
+{
+  // 1, 2, 4, ... and finally every hardware thread.
+  size_t maxThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+  std::vector<size_t> threadCounts;
+  for (size_t t = 1; t < maxThreads; t *= 2)
+    threadCounts.push_back(t);
+  threadCounts.push_back(maxThreads);
+  for (size_t n : sizes)
+  {
+    if (n < 100000)
+      continue;
+    TList<size_t> l;
+    for (size_t i = 0; i < n; i++)
+      l.push_back(i);
+    TList<size_t> out(n, 0);
+    for (size_t threads : threadCounts)
+    {
+      std::string suffix = "_t" + std::to_string(threads);
+      report.Add("parallel_for_each" + suffix, "TList", n, BenchBestOf(n, [&]() {
+        TBenchTimer t;
+        tlist::parallel_for_each(l, [](size_t& x) { x = Work(x); }, threads);
+        return t.ElapsedNs() / double(n);
+      }));
+      report.Add("parallel_transform" + suffix, "TList", n, BenchBestOf(n, [&]() {
+        TBenchTimer t;
+        tlist::parallel_transform(l, out, Work, threads);
+        return t.ElapsedNs() / double(n);
+      }));
+    }
+  }
+}
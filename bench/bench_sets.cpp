@@ -0,0 +1,103 @@
+#include "bench.h"
+#include "tlist.h"
+
+#include <algorithm>
+#include <mutex>
+#include <random>
+#include <thread>
+
+namespace
+{
+  // Sorted TList behind one mutex, the baseline the concurrent sets replace.
+  class TLockedSet
+  {
+  public:
+    bool insert(size_t v)
+    {
+      std::lock_guard<std::mutex> lock(m);
+      auto it = std::find_if(l.begin(), l.end(), [v](size_t x) { return x >= v; });
+      if (it != l.end() && *it == v)
+        return false;
+      l.insert(it, v);
+      return true;
+    }
+
+    bool erase(size_t v)
+    {
+      std::lock_guard<std::mutex> lock(m);
+      auto it = std::find_if(l.begin(), l.end(), [v](size_t x) { return x >= v; });
+      if (it == l.end() || *it != v)
+        return false;
+      l.erase(it);
+      return true;
+    }
+
+    bool contains(size_t v)
+    {
+      std::lock_guard<std::mutex> lock(m);
+      auto it = std::find_if(l.begin(), l.end(), [v](size_t x) { return x >= v; });
+      return it != l.end() && *it == v;
+    }
+
+  private:
+    std::mutex m;
+    TList<size_t> l;
+  };
+
+  const size_t OpsPerRun = 20000;
+
+  // Keys come from [0, n); the set starts half full. writePercent of the
+  // operations insert or erase, the rest are lookups. Returns ns per
+  // operation over all threads.
+  template <class S>
+  double RunMix(size_t threadCount, size_t n, unsigned writePercent)
+  {
+    S s;
+    for (size_t k = 0; k < n; k += 2)
+      s.insert(k);
+    size_t perThread = OpsPerRun / threadCount;
+    std::vector<std::thread> threads;
+    TBenchTimer t;
+    for (size_t i = 0; i < threadCount; i++)
+      threads.emplace_back([&s, i, n, perThread, writePercent]() {
+        std::minstd_rand rng(unsigned(i + 1));
+        size_t hits = 0;
+        for (size_t op = 0; op < perThread; op++)
+        {
+          size_t key = rng() % n;
+          unsigned dice = rng() % 100;
+          if (dice < writePercent)
+            hits += dice % 2 ? s.insert(key) : s.erase(key);
+          else
+            hits += s.contains(key);
+        }
+        BenchSink(hits);
+      });
+    for (auto& th : threads)
+      th.join();
+    return t.ElapsedNs() / double(perThread * threadCount);
+  }
+}
+
+// Sorted-set workloads over 1..8 threads at 0, 10 and 50 percent writes:
+// TLockCoupledList and TConcurrentSortedList against a mutex-guarded TList.
+// Every operation walks half the list on average, so sizes stop at 10^4.
+void BenchSets(TBenchReport& report, const std::vector<size_t>& sizes)
+{
+  for (size_t n : sizes)
+  {
+    if (n < 100 || n > 10000)
+      continue;
+    for (unsigned writePercent : { 0u, 10u, 50u })
+      for (size_t threads = 1; threads <= 8; threads *= 2)
+      {
+        std::string bench = "set_w" + std::to_string(writePercent) + "_t" + std::to_string(threads);
+        report.Add(bench, "TLockCoupledList", n,
+                   BenchBestOf(OpsPerRun, [&]() { return RunMix<TLockCoupledList<size_t>>(threads, n, writePercent); }));
+        report.Add(bench, "TConcurrentSortedList", n,
+                   BenchBestOf(OpsPerRun, [&]() { return RunMix<TConcurrentSortedList<size_t>>(threads, n, writePercent); }));
+        report.Add(bench, "mutex+TList", n,
+                   BenchBestOf(OpsPerRun, [&]() { return RunMix<TLockedSet>(threads, n, writePercent); }));
+      }
+  }
+}
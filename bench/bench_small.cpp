@@ -0,0 +1,52 @@
+#include "bench.h"
+#include "tlist.h"
+
+#include <algorithm>
+
+namespace
+{
+  const size_t Lengths[] = { 1, 4, 8, 16 };
+
+  // Builds, walks and destroys count lists of the given length. Reports ns
+  // per list and the heap bytes one live list holds per element.
+  template <class L>
+  void CreateDestroy(TBenchReport& report, const char* name, size_t length, size_t count)
+  {
+    double ns = BenchBestOf(count, [&]() {
+      TBenchTimer t;
+      size_t sum = 0;
+      for (size_t i = 0; i < count; i++)
+      {
+        L l;
+        for (size_t k = 0; k < length; k++)
+          l.push_back(int(k + i));
+        sum += size_t(l.back());
+      }
+      double e = t.ElapsedNs();
+      BenchSink(sum);
+      return e;
+    });
+    size_t before = BenchLiveBytes();
+    L l;
+    for (size_t k = 0; k < length; k++)
+      l.push_back(int(k));
+    double bytes = double(BenchLiveBytes() - before) / double(length);
+    report.Add("short_list", name, length, ns / double(count), bytes);
+  }
+}
+
+// Many short-lived short lists: with inline nodes a list of up to N
+// elements costs no allocator calls at all. The size column is the list
+// length; each row builds up to a million lists.
+void BenchSmall(TBenchReport& report, const std::vector<size_t>& sizes)
+{
+  using TPlain = TList<int, TBenchAllocator<int>>;
+  using TSmall8 = TSmallList<int, 8, TBenchAllocator<int>>;
+
+  size_t count = std::min<size_t>(sizes.empty() ? 0 : sizes.back(), 1000000);
+  for (size_t length : Lengths)
+  {
+    CreateDestroy<TPlain>(report, "TList", length, count);
+    CreateDestroy<TSmall8>(report, "TSmallList<8>", length, count);
+  }
+}
@@ -0,0 +1,112 @@
+#include "bench.h"
+#include "tlist.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace
+{
+  // Element heavy enough that copying it around costs as much as comparing.
+  struct THeavy
+  {
+    uint64_t key;
+    char payload[56];
+
+    bool operator<(const THeavy& o) const { return key < o.key; }
+  };
+
+  // Two copies of 10^7 heavy elements would not fit comfortably in memory.
+  const size_t HeavyLimit = 1000000;
+
+  template <class T>
+  T MakeElement(uint64_t k);
+
+  template <>
+  int MakeElement<int>(uint64_t k)
+  {
+    return static_cast<int>(k);
+  }
+
+  template <>
+  THeavy MakeElement<THeavy>(uint64_t k)
+  {
+    THeavy h;
+    h.key = k;
+    std::fill(std::begin(h.payload), std::end(h.payload), char(k));
+    return h;
+  }
+
+  uint32_t SortKey(int v)
+  {
+    return static_cast<uint32_t>(v);
+  }
+
+  uint64_t SortKey(const THeavy& v)
+  {
+    return v.key;
+  }
+
+  template <class T>
+  TList<T> MakeShuffled(size_t n)
+  {
+    TList<T> l;
+    uint64_t x = 88172645463325252ull;
+    for (size_t i = 0; i < n; i++)
+    {
+      x ^= x << 13;
+      x ^= x >> 7;
+      x ^= x << 17;
+      l.push_back(MakeElement<T>(x % (n + 1)));
+    }
+    return l;
+  }
+
+  template <class T>
+  void BenchSortOf(TBenchReport& report, const std::string& type, size_t n)
+  {
+    double relink = BenchBestOf(n, [&]() {
+      TList<T> l = MakeShuffled<T>(n);
+      TBenchTimer t;
+      l.sort();
+      return t.ElapsedNs();
+    });
+    report.Add("sort", "TList<" + type + ">::sort", n, relink / double(n));
+
+    double parallel = BenchBestOf(n, [&]() {
+      TList<T> l = MakeShuffled<T>(n);
+      TBenchTimer t;
+      l.parallel_sort();
+      return t.ElapsedNs();
+    });
+    report.Add("sort", "TList<" + type + ">::parallel_sort", n, parallel / double(n));
+
+    double radix = BenchBestOf(n, [&]() {
+      TList<T> l = MakeShuffled<T>(n);
+      TBenchTimer t;
+      l.radix_sort([](const T& v) { return SortKey(v); });
+      return t.ElapsedNs();
+    });
+    report.Add("sort", "TList<" + type + ">::radix_sort", n, radix / double(n));
+
+    // The alternative the list sort replaces: copy out, sort, copy back.
+    double viaVector = BenchBestOf(n, [&]() {
+      TList<T> l = MakeShuffled<T>(n);
+      TBenchTimer t;
+      std::vector<T> v(l.begin(), l.end());
+      std::stable_sort(v.begin(), v.end());
+      std::copy(v.begin(), v.end(), l.begin());
+      return t.ElapsedNs();
+    });
+    report.Add("sort", "TList<" + type + ">+vector+std::stable_sort", n, viaVector / double(n));
+  }
+}
+
+void BenchSort(TBenchReport& report, const std::vector<size_t>& sizes)
+{
+  for (size_t n : sizes)
+  {
+    BenchSortOf<int>(report, "int", n);
+    if (n <= HeavyLimit)
+      BenchSortOf<THeavy>(report, "heavy", n);
+  }
+}
@@ -0,0 +1,21 @@
+#include "bench.h"
+#include "tlist.h"
+
+// Full scans are dominated by pointer chasing; the unrolled list follows one
+// link per node instead of one per element.
+void BenchUnrolled(TBenchReport& report, const std::vector<size_t>& sizes)
+{
+  using TPlain = TList<int, TBenchAllocator<int>>;
+  using TUnrolled8 = TUnrolledList<int, 8, TBenchAllocator<int>>;
+  using TUnrolled16 = TUnrolledList<int, 16, TBenchAllocator<int>>;
+
+  for (size_t n : sizes)
+  {
+    BenchPushBack<TPlain>(report, "TList", n);
+    BenchPushBack<TUnrolled8>(report, "TUnrolledList<8>", n);
+    BenchPushBack<TUnrolled16>(report, "TUnrolledList<16>", n);
+    BenchTraversal<TPlain>(report, "TList", n);
+    BenchTraversal<TUnrolled8>(report, "TUnrolledList<8>", n);
+    BenchTraversal<TUnrolled16>(report, "TUnrolledList<16>", n);
+  }
+}
@@ -1,4 +1,5791 @@
 ﻿#pragma once
 #include <iostream>
 #include <stdexcept>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <utility>
+#include <type_traits>
+#include <initializer_list>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <new>
+#include <thread>
+#include <vector>
 
+// Marks the parts of TList that can run during constant evaluation. That
+// needs C++20 (transient allocation, constexpr destructors and
+// std::allocator); under C++17 the macro expands to nothing and
+// TLIST_HAS_CONSTEXPR is 0.
+#if defined(__cpp_constexpr_dynamic_alloc) && defined(__cpp_lib_constexpr_dynamic_alloc)
+#define TLIST_CONSTEXPR constexpr
+#define TLIST_HAS_CONSTEXPR 1
+#else
+#define TLIST_CONSTEXPR
+#define TLIST_HAS_CONSTEXPR 0
+#endif
+
+// 1 when built with ThreadSanitizer, which does not understand standalone
+// fences; TEpochDomain uses seq_cst stores instead there.
+#if defined(__SANITIZE_THREAD__)
+#define TLIST_TSAN 1
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define TLIST_TSAN 1
+#endif
+#endif
+#ifndef TLIST_TSAN
+#define TLIST_TSAN 0
+#endif
+
+// Link part of a list node. The list keeps one of these as a sentinel, so
+// the chain is circular and insertion/removal never has to special-case the
+// ends.
+struct TListNodeBase
+{
+  TListNodeBase* pNext;
+  TListNodeBase* pPrev;
+};
+
+// Node carrying a value. The value lives in an anonymous union so that the
+// list can obtain raw node memory from the allocator and construct the value
+// separately through the allocator's construct().
+template <class T>
+struct TListNode : TListNodeBase
+{
+  union
+  {
+    T value;
+  };
+
+  TLIST_CONSTEXPR TListNode() {}
+  TLIST_CONSTEXPR ~TListNode() {}
+};
+
+// Node of a TRankedList. pTower is the node's skip index tower, or null if
+// it has none, so the index can find the position of a node it is handed.
+template <class T>
+struct TRankedListNode : TListNode<T>
+{
+  void* pTower = nullptr;
+};
+
+// Maps a radix sort key to an unsigned integer of the same width whose
+// natural order is the order of the key. Signed integers get their sign bit
+// flipped; for floating point keys negative values have all bits inverted,
+// -0.0 sorts as +0.0 and every NaN sorts after +infinity.
+template <class K, class = void>
+struct TRadixKey
+{
+  static_assert(std::is_integral<K>::value, "TRadixKey: key must be an integer or floating point type");
+
+  using type = std::make_unsigned_t<std::conditional_t<std::is_same<K, bool>::value, unsigned char, K>>;
+
+  static type Bits(K k) noexcept
+  {
+    type u = static_cast<type>(k);
+    if constexpr (std::is_signed<K>::value)
+      u ^= type(1) << (sizeof(type) * 8 - 1);
+    return u;
+  }
+};
+
+template <class K>
+struct TRadixKey<K, std::enable_if_t<std::is_floating_point<K>::value>>
+{
+  static_assert(sizeof(K) == 4 || sizeof(K) == 8, "TRadixKey: only 32- and 64-bit floating point keys are supported");
+
+  using type = std::conditional_t<sizeof(K) == 4, uint32_t, uint64_t>;
+
+  static type Bits(K k) noexcept
+  {
+    if (k != k)
+      return ~type(0);
+    if (k == 0)
+      k = 0;
+    type u;
+    std::memcpy(&u, &k, sizeof(u));
+    const type sign = type(1) << (sizeof(type) * 8 - 1);
+    return (u & sign) ? ~u : (u | sign);
+  }
+};
+
+namespace tlist
+{
+  // Segments shorter than this are not worth a thread of their own.
+  const size_t ParallelGrain = 1024;
+
+  // Number of segments to cut n elements into for the given thread count;
+  // 0 threads means one per hardware thread.
+  inline size_t ParallelParts(size_t n, size_t threads)
+  {
+    if (threads == 0)
+      threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    return std::max<size_t>(1, std::min(threads, n / ParallelGrain));
+  }
+
+  // Walks the n elements from first once and returns parts + 1 boundaries
+  // cutting them into segments whose lengths differ by at most one.
+  template <class It>
+  std::vector<It> SplitPoints(It first, size_t n, size_t parts)
+  {
+    std::vector<It> points;
+    points.reserve(parts + 1);
+    points.push_back(first);
+    for (size_t i = 0; i < parts; i++)
+    {
+      size_t len = n / parts + (i < n % parts ? 1 : 0);
+      std::advance(first, len);
+      points.push_back(first);
+    }
+    return points;
+  }
+
+  // Runs body(0) .. body(parts - 1), all but the first on new threads, and
+  // rethrows the first exception any of them threw once all are done. If a
+  // thread cannot be started, that part and the ones after it run on the
+  // calling thread instead. Thread is only replaced by tests.
+  template <class Thread = std::thread, class F>
+  void RunParts(size_t parts, F& body)
+  {
+    std::vector<std::exception_ptr> errors(parts);
+    auto run = [&body, &errors](size_t i) {
+      try
+      {
+        body(i);
+      }
+      catch (...)
+      {
+        errors[i] = std::current_exception();
+      }
+    };
+    std::vector<Thread> workers;
+    size_t started = 1;
+    try
+    {
+      workers.reserve(parts - 1);
+      for (; started < parts; started++)
+        workers.emplace_back(run, started);
+    }
+    catch (...)
+    {
+      // Out of threads or memory; the workers already running are kept.
+    }
+    run(0);
+    for (size_t i = started; i < parts; i++)
+      run(i);
+    for (Thread& w : workers)
+      w.join();
+    for (std::exception_ptr& e : errors)
+      if (e)
+        std::rethrow_exception(e);
+  }
+}
+
+// Order-statistic skip index kept next to a TList when its Ranked parameter
+// is set (see TRankedList). Level 0 is the list itself; roughly one node in
+// four also gets a tower whose links skip a known number of nodes, so
+// locating position i descends the towers in O(log n) and finishes with a
+// walk of a few nodes. Every node points back at its tower, so the position
+// of a node is found the other way round: walk to the nearest tower, then
+// climb to the end of the list. Single-element inserts, erases and splices,
+// positional or through iterators, update the towers in O(log n) expected.
+// Bulk changes (splicing a range, sort, merge, reverse, swap) only mark the
+// index stale; the next non-const positional access rebuilds it in one pass,
+// while const access walks the list until then, so concurrent readers never
+// write to the index. Towers come from Alloc rebound to the tower types.
+//
+// The primary template is the disabled index: it is empty and its hooks
+// compile to nothing, so a plain TList pays neither space nor time.
+template <class Alloc, bool Enabled>
+class TListSkipIndex
+{
+public:
+  template <class A>
+  explicit TLIST_CONSTEXPR TListSkipIndex(const A&) noexcept {}
+
+  TLIST_CONSTEXPR void Invalidate() noexcept {}
+  TLIST_CONSTEXPR void Cleared() noexcept {}
+  TLIST_CONSTEXPR void Inserted(size_t, TListNodeBase*, size_t) {}
+  TLIST_CONSTEXPR void Erased(size_t, const TListNodeBase*, size_t) noexcept {}
+  TLIST_CONSTEXPR void Linked(TListNodeBase*, const TListNodeBase*, size_t) noexcept {}
+  TLIST_CONSTEXPR void Unlinking(const TListNodeBase*, const TListNodeBase*, size_t) noexcept {}
+  template <class A>
+  TLIST_CONSTEXPR void Rebind(const A&) noexcept {}
+};
+
+template <class Alloc>
+class TListSkipIndex<Alloc, true>
+{
+  struct TTower;
+
+  struct TSkipLink
+  {
+    TTower* pNext;
+    // Distance in list positions to pNext, or to one past the last element
+    // when pNext is null.
+    size_t width;
+  };
+
+  struct TTower
+  {
+    const TListNodeBase* pNode;
+    TSkipLink* links;
+    unsigned height;
+  };
+
+  using TTowerAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<TTower>;
+  using TTowerTraits = std::allocator_traits<TTowerAlloc>;
+  using TLinkAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<TSkipLink>;
+  using TLinkTraits = std::allocator_traits<TLinkAlloc>;
+  using TNode = TRankedListNode<typename std::allocator_traits<Alloc>::value_type>;
+
+  // Each level holds about a quarter of the towers of the level below.
+  static const unsigned MaxLevels = 24;
+
+public:
+  template <class A>
+  explicit TListSkipIndex(const A& alloc) noexcept : towerAlloc(alloc), linkAlloc(alloc) {}
+
+  TListSkipIndex(const TListSkipIndex&) = delete;
+  TListSkipIndex& operator=(const TListSkipIndex&) = delete;
+
+  ~TListSkipIndex() { FreeTowers(); }
+
+  void Invalidate() noexcept { stale = true; }
+
+  // The list was emptied; an empty index is up to date.
+  void Cleared() noexcept
+  {
+    FreeTowers();
+    stale = false;
+  }
+
+  // Records that node was inserted at position i of a list that now holds
+  // count elements. Call after linking. Without memory for a tower the
+  // index just goes stale.
+  void Inserted(size_t i, TListNodeBase* node, size_t count) noexcept
+  {
+    if (stale)
+      return;
+    TTower* update[MaxLevels];
+    size_t rankAt[MaxLevels];
+    Descend(i, update, rankAt);
+    unsigned h = RandomHeight();
+    TTower* t = nullptr;
+    if (h > 0)
+    {
+      try
+      {
+        t = CreateTower(node, h);
+      }
+      catch (...)
+      {
+        stale = true;
+        return;
+      }
+      for (; levels < h; levels++)
+      {
+        head[levels] = TSkipLink{ nullptr, count };
+        update[levels] = nullptr;
+        rankAt[levels] = 0;
+      }
+    }
+    TowerSlot(node) = t;
+    // Ranks count the head as 0, so the new node has rank i + 1.
+    for (unsigned l = 0; l < levels; l++)
+    {
+      TSkipLink& link = Link(update[l], l);
+      if (l < h)
+      {
+        t->links[l] = TSkipLink{ link.pNext, rankAt[l] + link.width - i };
+        link = TSkipLink{ t, i + 1 - rankAt[l] };
+      }
+      else
+        link.width++;
+    }
+  }
+
+  // Records that node, which was at position i, has been unlinked. Call
+  // before the node is freed.
+  void Erased(size_t i, const TListNodeBase* node, size_t) noexcept
+  {
+    if (stale)
+      return;
+    TTower* update[MaxLevels];
+    size_t rankAt[MaxLevels];
+    Descend(i, update, rankAt);
+    TTower* gone = nullptr;
+    for (unsigned l = 0; l < levels; l++)
+    {
+      TSkipLink& link = Link(update[l], l);
+      if (link.pNext != nullptr && link.pNext->pNode == node)
+      {
+        gone = link.pNext;
+        link = TSkipLink{ gone->links[l].pNext, link.width + gone->links[l].width - 1 };
+      }
+      else
+        link.width--;
+    }
+    while (levels > 0 && head[levels - 1].pNext == nullptr)
+      levels--;
+    if (gone != nullptr)
+      DestroyTower(gone);
+  }
+
+  // Same as Inserted for a node linked in through an iterator, whose
+  // position the list does not know.
+  void Linked(TListNodeBase* node, const TListNodeBase* sentinel, size_t count) noexcept
+  {
+    if (!stale)
+      Inserted(PositionOf(node->pNext, sentinel, count - 1), node, count);
+  }
+
+  // Same as Erased for a node about to be unlinked through an iterator;
+  // count still includes it.
+  void Unlinking(const TListNodeBase* node, const TListNodeBase* sentinel, size_t count) noexcept
+  {
+    if (!stale)
+      Erased(PositionOf(node, sentinel, count), node, count - 1);
+  }
+
+  // Rebuilds a stale index. Only the list's non-const members call this.
+  void Refresh(TListNodeBase* sentinel, size_t count) noexcept
+  {
+    if (stale)
+      Rebuild(sentinel, count);
+  }
+
+  // Node at position i of the list behind sentinel; i < count. A stale
+  // index is not rebuilt here, the list is walked from the nearer end.
+  const TListNodeBase* Locate(size_t i, const TListNodeBase* sentinel, size_t count) const noexcept
+  {
+    if (stale)
+    {
+      const TListNodeBase* p;
+      if (i < count / 2)
+        for (p = sentinel->pNext; i > 0; i--)
+          p = p->pNext;
+      else
+        for (p = sentinel->pPrev; ++i < count;)
+          p = p->pPrev;
+      return p;
+    }
+    TTower* update[MaxLevels];
+    size_t rankAt[MaxLevels];
+    TTower* t = Descend(i + 1, update, rankAt);
+    const TListNodeBase* p = t != nullptr ? t->pNode : sentinel;
+    for (size_t r = levels > 0 ? rankAt[0] : 0; r < i + 1; r++)
+      p = p->pNext;
+    return p;
+  }
+
+  // The owning list switched allocators.
+  template <class A>
+  void Rebind(const A& alloc) noexcept
+  {
+    FreeTowers();
+    towerAlloc = TTowerAlloc(alloc);
+    linkAlloc = TLinkAlloc(alloc);
+  }
+
+private:
+  TTowerAlloc towerAlloc;
+  TLinkAlloc linkAlloc;
+  // The head tower at rank 0; null in update[] below stands for it.
+  TSkipLink head[MaxLevels];
+  unsigned levels = 0;
+  bool stale = true;
+  uint64_t seed = 0x9e3779b97f4a7c15ull;
+
+  TSkipLink& Link(TTower* t, unsigned level) noexcept { return t != nullptr ? t->links[level] : head[level]; }
+  const TSkipLink& Link(const TTower* t, unsigned level) const noexcept { return t != nullptr ? t->links[level] : head[level]; }
+
+  static void*& TowerSlot(TListNodeBase* p) noexcept { return static_cast<TNode*>(p)->pTower; }
+  static const TTower* TowerOf(const TListNodeBase* p) noexcept
+  {
+    return static_cast<const TTower*>(static_cast<const TNode*>(p)->pTower);
+  }
+
+  // Position of node (or count for sentinel) in a list of count elements
+  // that the index is up to date with. Walks to the next node with a
+  // tower, then climbs to the end of the list along the top link of each
+  // tower met, which is a search path run backwards: expected O(log n).
+  size_t PositionOf(const TListNodeBase* node, const TListNodeBase* sentinel, size_t count) const noexcept
+  {
+    size_t d = 0;
+    const TListNodeBase* p = node;
+    for (; p != sentinel && TowerOf(p) == nullptr; p = p->pNext)
+      d++;
+    // Widths add up to the distance from p to one past the last element.
+    size_t toEnd = 0;
+    if (p != sentinel)
+      for (const TTower* t = TowerOf(p); t != nullptr;)
+      {
+        const TSkipLink& link = t->links[t->height - 1];
+        toEnd += link.width;
+        t = link.pNext;
+      }
+    return count - toEnd - d;
+  }
+
+  // Finds on every level the last tower whose rank is at most target.
+  // Returns the one on the lowest level (null for the head).
+  TTower* Descend(size_t target, TTower** update, size_t* rankAt) const noexcept
+  {
+    TTower* t = nullptr;
+    size_t rank = 0;
+    for (unsigned l = levels; l-- > 0;)
+    {
+      while (true)
+      {
+        const TSkipLink& link = Link(t, l);
+        if (link.pNext == nullptr || rank + link.width > target)
+          break;
+        rank += link.width;
+        t = link.pNext;
+      }
+      update[l] = t;
+      rankAt[l] = rank;
+    }
+    return t;
+  }
+
+  unsigned RandomHeight() noexcept
+  {
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    unsigned h = 0;
+    for (uint64_t bits = seed; h < MaxLevels && (bits & 3) == 0; bits >>= 2)
+      h++;
+    return h;
+  }
+
+  // Towers at regular spacing: rank r gets one level per factor of four.
+  // Returns false if memory ran out, leaving the index stale.
+  bool Rebuild(TListNodeBase* sentinel, size_t count) noexcept
+  {
+    FreeTowers();
+    TTower* last[MaxLevels];
+    size_t lastRank[MaxLevels];
+    size_t rank = 0;
+    bool complete = true;
+    for (TListNodeBase* p = sentinel->pNext; p != sentinel; p = p->pNext)
+    {
+      rank++;
+      unsigned h = 0;
+      for (size_t r = rank; h < MaxLevels && r % 4 == 0; r /= 4)
+        h++;
+      TowerSlot(p) = nullptr;
+      if (h == 0)
+        continue;
+      TTower* t;
+      try
+      {
+        t = CreateTower(p, h);
+      }
+      catch (...)
+      {
+        complete = false;
+        break;
+      }
+      for (; levels < h; levels++)
+      {
+        last[levels] = nullptr;
+        lastRank[levels] = 0;
+      }
+      TowerSlot(p) = t;
+      for (unsigned l = 0; l < h; l++)
+      {
+        Link(last[l], l) = TSkipLink{ t, rank - lastRank[l] };
+        last[l] = t;
+        lastRank[l] = rank;
+      }
+    }
+    // Terminating the chains also keeps a partial build walkable for
+    // FreeTowers.
+    for (unsigned l = 0; l < levels; l++)
+      Link(last[l], l) = TSkipLink{ nullptr, count + 1 - lastRank[l] };
+    stale = !complete;
+    return complete;
+  }
+
+  TTower* CreateTower(const TListNodeBase* node, unsigned h)
+  {
+    TTower* t = std::addressof(*TTowerTraits::allocate(towerAlloc, 1));
+    try
+    {
+      TSkipLink* links = std::addressof(*TLinkTraits::allocate(linkAlloc, h));
+      TTowerTraits::construct(towerAlloc, t, TTower{ node, links, h });
+    }
+    catch (...)
+    {
+      TTowerTraits::deallocate(towerAlloc, t, 1);
+      throw;
+    }
+    return t;
+  }
+
+  void DestroyTower(TTower* t) noexcept
+  {
+    TLinkTraits::deallocate(linkAlloc, t->links, t->height);
+    TTowerTraits::destroy(towerAlloc, t);
+    TTowerTraits::deallocate(towerAlloc, t, 1);
+  }
+
+  // Every tower is on level 0, so one walk there finds them all, even when
+  // the widths are stale.
+  void FreeTowers() noexcept
+  {
+    TTower* t = levels > 0 ? head[0].pNext : nullptr;
+    while (t != nullptr)
+    {
+      TTower* next = t->links[0].pNext;
+      DestroyTower(t);
+      t = next;
+    }
+    levels = 0;
+    stale = true;
+  }
+};
+
+template <class T, class Alloc = std::allocator<T>, bool Ranked = false>
+class TList;
+
+template <class T, bool IsConst>
+class TListIterator
+{
+public:
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = T;
+  using difference_type = std::ptrdiff_t;
+  using pointer = std::conditional_t<IsConst, const T*, T*>;
+  using reference = std::conditional_t<IsConst, const T&, T&>;
+
+  TLIST_CONSTEXPR TListIterator() : pNode(nullptr) {}
+  explicit TLIST_CONSTEXPR TListIterator(const TListNodeBase* p) : pNode(const_cast<TListNodeBase*>(p)) {}
+
+  template <bool C = IsConst, class = std::enable_if_t<C>>
+  TLIST_CONSTEXPR TListIterator(const TListIterator<T, false>& it) : pNode(it.pNode) {}
+
+  TLIST_CONSTEXPR reference operator*() const { return static_cast<TListNode<T>*>(pNode)->value; }
+  TLIST_CONSTEXPR pointer operator->() const { return std::addressof(**this); }
+
+  TLIST_CONSTEXPR TListIterator& operator++()
+  {
+    pNode = pNode->pNext;
+    return *this;
+  }
+
+  TLIST_CONSTEXPR TListIterator operator++(int)
+  {
+    TListIterator tmp = *this;
+    pNode = pNode->pNext;
+    return tmp;
+  }
+
+  TLIST_CONSTEXPR TListIterator& operator--()
+  {
+    pNode = pNode->pPrev;
+    return *this;
+  }
+
+  TLIST_CONSTEXPR TListIterator operator--(int)
+  {
+    TListIterator tmp = *this;
+    pNode = pNode->pPrev;
+    return tmp;
+  }
+
+  friend TLIST_CONSTEXPR bool operator==(const TListIterator& a, const TListIterator& b) { return a.pNode == b.pNode; }
+  friend TLIST_CONSTEXPR bool operator!=(const TListIterator& a, const TListIterator& b) { return a.pNode != b.pNode; }
+
+private:
+  TListNodeBase* pNode;
+
+  template <class, bool> friend class TListIterator;
+  template <class, class, bool> friend class TList;
+};
+
+// Doubly linked list. Nodes are obtained from Alloc rebound to the node type,
+// so pools and arenas can be plugged in without touching the list itself.
+// With Ranked set the list also keeps a TListSkipIndex for O(log n)
+// positional access; the index is an empty base otherwise.
+template <class T, class Alloc, bool Ranked>
+class TList : private TListSkipIndex<Alloc, Ranked>
+{
+  using TNode = std::conditional_t<Ranked, TRankedListNode<T>, TListNode<T>>;
+  using TNodeAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<TNode>;
+  using TNodeTraits = std::allocator_traits<TNodeAlloc>;
+  using TIndex = TListSkipIndex<Alloc, Ranked>;
+
+public:
+  using value_type = T;
+  using allocator_type = Alloc;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = typename std::allocator_traits<Alloc>::pointer;
+  using const_pointer = typename std::allocator_traits<Alloc>::const_pointer;
+  using iterator = TListIterator<T, false>;
+  using const_iterator = TListIterator<T, true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  TLIST_CONSTEXPR TList() : TList(Alloc()) {}
+
+  explicit TLIST_CONSTEXPR TList(const Alloc& alloc) : TIndex(alloc), nodeAlloc(alloc)
+  {
+    Reset();
+  }
+
+  TLIST_CONSTEXPR TList(size_type n, const T& value, const Alloc& alloc = Alloc()) : TList(alloc)
+  {
+    for (size_type i = 0; i < n; i++)
+      push_back(value);
+  }
+
+  template <class InputIt, class = std::enable_if_t<!std::is_integral<InputIt>::value>>
+  TLIST_CONSTEXPR TList(InputIt first, InputIt last, const Alloc& alloc = Alloc()) : TList(alloc)
+  {
+    for (; first != last; ++first)
+      emplace_back(*first);
+  }
+
+  TLIST_CONSTEXPR TList(std::initializer_list<T> init, const Alloc& alloc = Alloc()) : TList(init.begin(), init.end(), alloc) {}
+
+  TLIST_CONSTEXPR TList(const TList& other)
+    : TList(other, TNodeTraits::select_on_container_copy_construction(other.nodeAlloc)) {}
+
+  TLIST_CONSTEXPR TList(const TList& other, const Alloc& alloc) : TList(alloc)
+  {
+    for (const T& v : other)
+      push_back(v);
+  }
+
+  TLIST_CONSTEXPR TList(TList&& other) noexcept : TIndex(other.nodeAlloc), nodeAlloc(std::move(other.nodeAlloc))
+  {
+    Reset();
+    Steal(other);
+  }
+
+  TLIST_CONSTEXPR TList(TList&& other, const Alloc& alloc) : TList(alloc)
+  {
+    if (nodeAlloc == other.nodeAlloc)
+      Steal(other);
+    else
+      for (T& v : other)
+        push_back(std::move(v));
+  }
+
+  TLIST_CONSTEXPR ~TList()
+  {
+    clear();
+  }
+
+  TLIST_CONSTEXPR TList& operator=(const TList& other)
+  {
+    if (this == &other)
+      return *this;
+    if constexpr (TNodeTraits::propagate_on_container_copy_assignment::value)
+    {
+      if (nodeAlloc != other.nodeAlloc)
+        clear();
+      nodeAlloc = other.nodeAlloc;
+      Index().Rebind(nodeAlloc);
+    }
+    AssignRange(other.begin(), other.end());
+    return *this;
+  }
+
+  TLIST_CONSTEXPR TList& operator=(TList&& other) noexcept(TNodeTraits::propagate_on_container_move_assignment::value ||
+                                           TNodeTraits::is_always_equal::value)
+  {
+    if (this == &other)
+      return *this;
+    if constexpr (TNodeTraits::propagate_on_container_move_assignment::value)
+    {
+      clear();
+      nodeAlloc = std::move(other.nodeAlloc);
+      Index().Rebind(nodeAlloc);
+      Steal(other);
+    }
+    else if (nodeAlloc == other.nodeAlloc)
+    {
+      clear();
+      Steal(other);
+    }
+    else
+    {
+      AssignRange(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+      other.clear();
+    }
+    return *this;
+  }
+
+  TLIST_CONSTEXPR TList& operator=(std::initializer_list<T> init)
+  {
+    AssignRange(init.begin(), init.end());
+    return *this;
+  }
+
+  TLIST_CONSTEXPR allocator_type get_allocator() const { return allocator_type(nodeAlloc); }
+
+  TLIST_CONSTEXPR iterator begin() noexcept { return iterator(sentinel.pNext); }
+  TLIST_CONSTEXPR const_iterator begin() const noexcept { return const_iterator(sentinel.pNext); }
+  TLIST_CONSTEXPR const_iterator cbegin() const noexcept { return begin(); }
+  TLIST_CONSTEXPR iterator end() noexcept { return iterator(&sentinel); }
+  TLIST_CONSTEXPR const_iterator end() const noexcept { return const_iterator(&sentinel); }
+  TLIST_CONSTEXPR const_iterator cend() const noexcept { return end(); }
+  TLIST_CONSTEXPR reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  TLIST_CONSTEXPR const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+  TLIST_CONSTEXPR reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  TLIST_CONSTEXPR const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+  TLIST_CONSTEXPR bool empty() const noexcept { return count == 0; }
+  TLIST_CONSTEXPR size_type size() const noexcept { return count; }
+
+  TLIST_CONSTEXPR T& front()
+  {
+    CheckNotEmpty();
+    return Value(sentinel.pNext);
+  }
+
+  TLIST_CONSTEXPR const T& front() const
+  {
+    CheckNotEmpty();
+    return Value(sentinel.pNext);
+  }
+
+  TLIST_CONSTEXPR T& back()
+  {
+    CheckNotEmpty();
+    return Value(sentinel.pPrev);
+  }
+
+  TLIST_CONSTEXPR const T& back() const
+  {
+    CheckNotEmpty();
+    return Value(sentinel.pPrev);
+  }
+
+  TLIST_CONSTEXPR T& operator[](size_type i) { return Value(NodeAt(i)); }
+  TLIST_CONSTEXPR const T& operator[](size_type i) const { return Value(NodeAt(i)); }
+
+  TLIST_CONSTEXPR T& at(size_type i)
+  {
+    CheckIndex(i);
+    return Value(NodeAt(i));
+  }
+
+  TLIST_CONSTEXPR const T& at(size_type i) const
+  {
+    CheckIndex(i);
+    return Value(NodeAt(i));
+  }
+
+  TLIST_CONSTEXPR void push_front(const T& value) { emplace_front(value); }
+  TLIST_CONSTEXPR void push_front(T&& value) { emplace_front(std::move(value)); }
+  TLIST_CONSTEXPR void push_back(const T& value) { emplace_back(value); }
+  TLIST_CONSTEXPR void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  template <class... Args>
+  TLIST_CONSTEXPR T& emplace_front(Args&&... args)
+  {
+    return *emplace(begin(), std::forward<Args>(args)...);
+  }
+
+  template <class... Args>
+  TLIST_CONSTEXPR T& emplace_back(Args&&... args)
+  {
+    return *emplace(end(), std::forward<Args>(args)...);
+  }
+
+  TLIST_CONSTEXPR void pop_front()
+  {
+    CheckNotEmpty();
+    erase(begin());
+  }
+
+  TLIST_CONSTEXPR void pop_back()
+  {
+    CheckNotEmpty();
+    erase(iterator(sentinel.pPrev));
+  }
+
+  TLIST_CONSTEXPR iterator insert(const_iterator pos, const T& value) { return emplace(pos, value); }
+  TLIST_CONSTEXPR iterator insert(const_iterator pos, T&& value) { return emplace(pos, std::move(value)); }
+
+  template <class... Args>
+  TLIST_CONSTEXPR iterator emplace(const_iterator pos, Args&&... args)
+  {
+    TNode* p = CreateNode(std::forward<Args>(args)...);
+    Link(pos.pNode, p);
+    count++;
+    Linked(p);
+    return iterator(p);
+  }
+
+  TLIST_CONSTEXPR iterator erase(const_iterator pos)
+  {
+    TListNodeBase* p = pos.pNode;
+    TListNodeBase* next = p->pNext;
+    Unlinking(p);
+    Unlink(p);
+    count--;
+    DestroyNode(static_cast<TNode*>(p));
+    return iterator(next);
+  }
+
+  // Positional insert and erase: O(log n) on a TRankedList, otherwise a walk
+  // like operator[]. insert_at accepts i == size() to append.
+  TLIST_CONSTEXPR iterator insert_at(size_type i, const T& value) { return emplace_at(i, value); }
+  TLIST_CONSTEXPR iterator insert_at(size_type i, T&& value) { return emplace_at(i, std::move(value)); }
+
+  template <class... Args>
+  TLIST_CONSTEXPR iterator emplace_at(size_type i, Args&&... args)
+  {
+    if (i > count)
+      throw std::out_of_range("TList: index out of range");
+    TNode* p = CreateNode(std::forward<Args>(args)...);
+    Link(i == count ? &sentinel : NodeAt(i), p);
+    count++;
+    Inserted(i, p);
+    return iterator(p);
+  }
+
+  TLIST_CONSTEXPR iterator erase_at(size_type i)
+  {
+    CheckIndex(i);
+    TListNodeBase* p = NodeAt(i);
+    TListNodeBase* next = p->pNext;
+    Erasing(i, p);
+    Unlink(p);
+    count--;
+    DestroyNode(static_cast<TNode*>(p));
+    return iterator(next);
+  }
+
+  TLIST_CONSTEXPR iterator erase(const_iterator first, const_iterator last)
+  {
+    while (first != last)
+      first = erase(first);
+    return iterator(last.pNode);
+  }
+
+  TLIST_CONSTEXPR void clear() noexcept
+  {
+    TListNodeBase* p = sentinel.pNext;
+    while (p != &sentinel)
+    {
+      TListNodeBase* next = p->pNext;
+      DestroyNode(static_cast<TNode*>(p));
+      p = next;
+    }
+    Reset();
+  }
+
+  // Splicing only relinks nodes: nothing is copied or allocated, and
+  // iterators to the moved elements stay valid, now pointing into this list.
+  // Both lists must use equal allocators.
+
+  // Moves all of other in front of pos. O(1).
+  TLIST_CONSTEXPR void splice(const_iterator pos, TList& other)
+  {
+    if (this == &other || other.count == 0)
+      return;
+    CheckSameAllocator(other);
+    Transfer(pos.pNode, other.sentinel.pNext, &other.sentinel);
+    count += other.count;
+    other.count = 0;
+    Restructured();
+    other.Restructured();
+  }
+
+  TLIST_CONSTEXPR void splice(const_iterator pos, TList&& other) { splice(pos, other); }
+
+  // Moves the element at it from other in front of pos. O(1).
+  TLIST_CONSTEXPR void splice(const_iterator pos, TList& other, const_iterator it)
+  {
+    TListNodeBase* p = it.pNode;
+    if (pos.pNode == p || pos.pNode == p->pNext)
+      return;
+    if (this != &other)
+      CheckSameAllocator(other);
+    other.Unlinking(p);
+    other.count--;
+    count++;
+    Transfer(pos.pNode, p, p->pNext);
+    Linked(p);
+  }
+
+  TLIST_CONSTEXPR void splice(const_iterator pos, TList&& other, const_iterator it) { splice(pos, other, it); }
+
+  // Moves [first, last) from other in front of pos. Linear in the length of
+  // the range when other is a different list (the range has to be counted),
+  // O(1) otherwise.
+  TLIST_CONSTEXPR void splice(const_iterator pos, TList& other, const_iterator first, const_iterator last)
+  {
+    size_type n = 0;
+    if (this != &other)
+      for (const_iterator it = first; it != last; ++it)
+        n++;
+    splice(pos, other, first, last, n);
+  }
+
+  TLIST_CONSTEXPR void splice(const_iterator pos, TList&& other, const_iterator first, const_iterator last)
+  {
+    splice(pos, other, first, last);
+  }
+
+  // Same as above for a range whose length n the caller already knows. O(1).
+  TLIST_CONSTEXPR void splice(const_iterator pos, TList& other, const_iterator first, const_iterator last, size_type n)
+  {
+    if (first == last)
+      return;
+    if (this != &other)
+    {
+      CheckSameAllocator(other);
+      other.count -= n;
+      count += n;
+    }
+    Transfer(pos.pNode, first.pNode, last.pNode);
+    Restructured();
+    other.Restructured();
+  }
+
+  // Moves all of other to the end of this list. O(1).
+  void append(TList&& other) { splice(end(), other); }
+
+  // Cuts the list in two: this keeps [begin, pos) and the returned list gets
+  // [pos, end). Only the shorter part is walked to fix up the sizes.
+  TList split_at(const_iterator pos)
+  {
+    TList tail(get_allocator());
+    if (pos.pNode == &sentinel)
+      return tail;
+    size_type n = TailLength(pos.pNode);
+    tail.splice(tail.end(), *this, pos, end(), n);
+    return tail;
+  }
+
+  // Merges the sorted list other into this sorted list in one pass by
+  // relinking: O(n + m), no allocation, and on ties elements of this list
+  // come first. other is left empty. Both lists must use equal allocators.
+  // If comp throws, all elements end up in this list in unspecified order.
+  template <class Compare>
+  void merge(TList& other, Compare comp)
+  {
+    if (this == &other || other.count == 0)
+      return;
+    CheckSameAllocator(other);
+    TListNodeBase* a = sentinel.pNext;
+    sentinel.pPrev->pNext = nullptr;
+    TListNodeBase* b = other.sentinel.pNext;
+    other.sentinel.pPrev->pNext = nullptr;
+    if (count == 0)
+      a = nullptr;
+    count += other.count;
+    other.Reset();
+    TListNodeBase* chain = nullptr;
+    try
+    {
+      MergeRuns(chain, a, b, comp);
+    }
+    catch (...)
+    {
+      RelinkChain(chain);
+      throw;
+    }
+    RelinkChain(chain);
+  }
+
+  template <class Compare>
+  void merge(TList&& other, Compare comp)
+  {
+    merge(other, comp);
+  }
+
+  void merge(TList& other) { merge(other, std::less<T>()); }
+  void merge(TList&& other) { merge(other, std::less<T>()); }
+
+  // Stable bottom-up merge sort. Nodes are relinked, never copied; no memory
+  // is allocated and there is no recursion: sorted runs of 2^i nodes are kept
+  // in a fixed array of bins and merged like a binary counter. If comp
+  // throws, all elements stay in the list in unspecified order.
+  template <class Compare>
+  void sort(Compare comp)
+  {
+    if (count < 2)
+      return;
+    TListNodeBase* bins[64] = {};
+    int fill = 0;
+    TListNodeBase* p = sentinel.pNext;
+    sentinel.pPrev->pNext = nullptr;
+    TListNodeBase* carry = nullptr;
+    TListNodeBase* result = nullptr;
+    try
+    {
+      while (p != nullptr)
+      {
+        carry = p;
+        p = p->pNext;
+        carry->pNext = nullptr;
+        int i = 0;
+        for (; i < fill && bins[i] != nullptr; i++)
+        {
+          TListNodeBase* run = bins[i];
+          bins[i] = nullptr;
+          MergeRuns(carry, run, carry, comp);
+        }
+        bins[i] = carry;
+        carry = nullptr;
+        if (i == fill)
+          fill++;
+      }
+      for (int i = 0; i < fill; i++)
+        if (bins[i] != nullptr)
+        {
+          TListNodeBase* run = bins[i];
+          bins[i] = nullptr;
+          MergeRuns(result, run, result, comp);
+        }
+      RelinkChain(result);
+    }
+    catch (...)
+    {
+      TListNodeBase* chain = ConcatChains(result, ConcatChains(carry, p));
+      for (int i = 0; i < fill; i++)
+        chain = ConcatChains(bins[i], chain);
+      RelinkChain(chain);
+      throw;
+    }
+  }
+
+  void sort() { sort(std::less<T>()); }
+
+  // sort() spread over up to threads threads (0: one per hardware thread).
+  // The list is cut into equal sublists that are sorted concurrently and
+  // then merged pairwise in a tree, again concurrently; nodes are only
+  // relinked. Stable. comp is copied for every worker. If comp throws, all
+  // elements stay in the list in unspecified order.
+  template <class Compare>
+  void parallel_sort(Compare comp, size_t threads = 0)
+  {
+    size_t parts = tlist::ParallelParts(count, threads);
+    if (parts < 2)
+    {
+      sort(comp);
+      return;
+    }
+    std::vector<TList> pieces;
+    pieces.reserve(parts);
+    std::vector<iterator> points = tlist::SplitPoints(begin(), count, parts);
+    size_type n = count;
+    for (size_t i = 0; i < parts; i++)
+    {
+      pieces.emplace_back(get_allocator());
+      pieces[i].splice(pieces[i].end(), *this, points[i], points[i + 1], n / parts + (i < n % parts ? 1 : 0));
+    }
+    try
+    {
+      auto sortPiece = [&pieces, &comp](size_t i) {
+        Compare c = comp;
+        pieces[i].sort(c);
+      };
+      tlist::RunParts(parts, sortPiece);
+      for (size_t width = 1; width < parts; width *= 2)
+      {
+        auto mergePair = [&pieces, &comp, width](size_t i) {
+          size_t left = i * 2 * width;
+          Compare c = comp;
+          pieces[left].merge(pieces[left + width], c);
+        };
+        tlist::RunParts((parts - width + 2 * width - 1) / (2 * width), mergePair);
+      }
+    }
+    catch (...)
+    {
+      for (TList& piece : pieces)
+        append(std::move(piece));
+      throw;
+    }
+    append(std::move(pieces[0]));
+  }
+
+  void parallel_sort() { parallel_sort(std::less<T>()); }
+
+  // Stable LSD radix sort on key(element), which must return an integer or
+  // a floating point value (see TRadixKey for the order). Each byte pass
+  // deals the nodes into 256 bucket chains and reconnects them, so the cost
+  // is O(n * sizeof(key)) with no comparisons and no element moves. A first
+  // pass builds the byte histograms, and bytes that are equal for every
+  // element are skipped. key is called once per node for the histograms and
+  // once per node for every remaining pass. If key throws, all elements stay
+  // in the list in unspecified order.
+  template <class KeyFn>
+  void radix_sort(KeyFn key)
+  {
+    using TKey = std::decay_t<decltype(key(std::declval<const T&>()))>;
+    using TBits = typename TRadixKey<TKey>::type;
+    constexpr size_t Passes = sizeof(TBits);
+
+    if (count < 2)
+      return;
+    size_t hist[Passes][256] = {};
+    for (TListNodeBase* p = sentinel.pNext; p != &sentinel; p = p->pNext)
+    {
+      TBits bits = TRadixKey<TKey>::Bits(key(Value(p)));
+      for (size_t pass = 0; pass < Passes; pass++)
+        hist[pass][(bits >> (pass * 8)) & 0xff]++;
+    }
+
+    TListNodeBase* chain = sentinel.pNext;
+    sentinel.pPrev->pNext = nullptr;
+    TListNodeBase* heads[256];
+    TListNodeBase** tails[256];
+    for (size_t pass = 0; pass < Passes; pass++)
+    {
+      if (std::find(std::begin(hist[pass]), std::end(hist[pass]), count) != std::end(hist[pass]))
+        continue;
+      for (int b = 0; b < 256; b++)
+      {
+        heads[b] = nullptr;
+        tails[b] = &heads[b];
+      }
+      TListNodeBase* p = chain;
+      try
+      {
+        while (p != nullptr)
+        {
+          size_t b = (TRadixKey<TKey>::Bits(key(Value(p))) >> (pass * 8)) & 0xff;
+          *tails[b] = p;
+          tails[b] = &p->pNext;
+          p = p->pNext;
+        }
+      }
+      catch (...)
+      {
+        *JoinBuckets(chain, heads, tails) = p;
+        RelinkChain(chain);
+        throw;
+      }
+      *JoinBuckets(chain, heads, tails) = nullptr;
+    }
+    RelinkChain(chain);
+  }
+
+  TLIST_CONSTEXPR void swap(TList& other) noexcept
+  {
+    if constexpr (TNodeTraits::propagate_on_container_swap::value)
+    {
+      using std::swap;
+      swap(nodeAlloc, other.nodeAlloc);
+      Index().Rebind(nodeAlloc);
+      other.Index().Rebind(other.nodeAlloc);
+    }
+    TListNodeBase tmp;
+    MoveChain(tmp, sentinel);
+    MoveChain(sentinel, other.sentinel);
+    MoveChain(other.sentinel, tmp);
+    std::swap(count, other.count);
+    Restructured();
+    other.Restructured();
+  }
+
+  friend TLIST_CONSTEXPR bool operator==(const TList& a, const TList& b)
+  {
+    if (a.count != b.count)
+      return false;
+    for (auto i = a.begin(), j = b.begin(); i != a.end(); ++i, ++j)
+      if (!(*i == *j))
+        return false;
+    return true;
+  }
+
+  friend TLIST_CONSTEXPR bool operator!=(const TList& a, const TList& b) { return !(a == b); }
+
+  friend std::ostream& operator<<(std::ostream& os, const TList& l)
+  {
+    os << '{';
+    for (auto it = l.begin(); it != l.end(); ++it)
+      os << (it == l.begin() ? "" : ", ") << *it;
+    return os << '}';
+  }
+
+private:
+  TListNodeBase sentinel;
+  size_type count;
+  TNodeAlloc nodeAlloc;
+  // Last node reached by position from a non-const member and its index,
+  // or null. Const access starts from it but never moves it, so concurrent
+  // const readers share the list without writing to it.
+  TListNodeBase* pCursor = nullptr;
+  size_type cursorIndex = 0;
+
+  static TLIST_CONSTEXPR T& Value(TListNodeBase* p) { return static_cast<TNode*>(p)->value; }
+  static TLIST_CONSTEXPR const T& Value(const TListNodeBase* p) { return static_cast<const TNode*>(p)->value; }
+
+  TLIST_CONSTEXPR TIndex& Index() noexcept { return *this; }
+  TLIST_CONSTEXPR const TIndex& Index() const noexcept { return *this; }
+
+  TLIST_CONSTEXPR void Reset() noexcept
+  {
+    sentinel.pNext = sentinel.pPrev = &sentinel;
+    count = 0;
+    Index().Cleared();
+    pCursor = nullptr;
+  }
+
+  // Positions of existing nodes changed in a way the skip index and the
+  // cursor cannot follow.
+  TLIST_CONSTEXPR void Restructured() noexcept
+  {
+    Index().Invalidate();
+    pCursor = nullptr;
+  }
+
+  // p was just linked in at position i; count includes it.
+  TLIST_CONSTEXPR void Inserted(size_type i, TListNodeBase* p) noexcept
+  {
+    Index().Inserted(i, p, count);
+    if (pCursor != nullptr && i <= cursorIndex)
+      cursorIndex++;
+  }
+
+  // p at position i is about to be unlinked; count still includes it.
+  TLIST_CONSTEXPR void Erasing(size_type i, TListNodeBase* p) noexcept
+  {
+    Index().Erased(i, p, count - 1);
+    if (p == pCursor)
+      pCursor = nullptr;
+    else if (pCursor != nullptr && i < cursorIndex)
+      cursorIndex--;
+  }
+
+  // Iterator inserts and erases only know the position of nodes at the
+  // ends. Anywhere else the skip index looks the position up itself and the
+  // cursor is dropped.
+  TLIST_CONSTEXPR void Linked(TListNodeBase* p) noexcept
+  {
+    if (p->pNext == &sentinel)
+      Inserted(count - 1, p);
+    else if (p->pPrev == &sentinel)
+      Inserted(0, p);
+    else
+    {
+      Index().Linked(p, &sentinel, count);
+      pCursor = nullptr;
+    }
+  }
+
+  TLIST_CONSTEXPR void Unlinking(TListNodeBase* p) noexcept
+  {
+    if (p->pNext == &sentinel)
+      Erasing(count - 1, p);
+    else if (p->pPrev == &sentinel)
+      Erasing(0, p);
+    else
+    {
+      Index().Unlinking(p, &sentinel, count);
+      pCursor = nullptr;
+    }
+  }
+
+  // Moves the chain hanging off sentinel from onto sentinel to, leaving from
+  // as an empty ring. Only the two end nodes are touched.
+  static TLIST_CONSTEXPR void MoveChain(TListNodeBase& to, TListNodeBase& from) noexcept
+  {
+    if (from.pNext == &from)
+    {
+      to.pNext = to.pPrev = &to;
+      return;
+    }
+    to.pNext = from.pNext;
+    to.pPrev = from.pPrev;
+    to.pNext->pPrev = &to;
+    to.pPrev->pNext = &to;
+    from.pNext = from.pPrev = &from;
+  }
+
+  // Takes over the chain of other (which must share our allocator) and
+  // leaves other empty.
+  TLIST_CONSTEXPR void Steal(TList& other) noexcept
+  {
+    MoveChain(sentinel, other.sentinel);
+    count = other.count;
+    other.count = 0;
+    Restructured();
+    other.Restructured();
+  }
+
+  // Reuses existing nodes by assignment and only allocates/frees the
+  // difference in length.
+  template <class InputIt>
+  TLIST_CONSTEXPR void AssignRange(InputIt first, InputIt last)
+  {
+    iterator it = begin();
+    for (; it != end() && first != last; ++it, ++first)
+      *it = *first;
+    if (first == last)
+      erase(it, end());
+    else
+      for (; first != last; ++first)
+        emplace_back(*first);
+  }
+
+  static TLIST_CONSTEXPR void Link(TListNodeBase* pos, TListNodeBase* p) noexcept
+  {
+    p->pNext = pos;
+    p->pPrev = pos->pPrev;
+    pos->pPrev->pNext = p;
+    pos->pPrev = p;
+  }
+
+  static TLIST_CONSTEXPR void Unlink(TListNodeBase* p) noexcept
+  {
+    p->pPrev->pNext = p->pNext;
+    p->pNext->pPrev = p->pPrev;
+  }
+
+  // Relinks the chain [first, last) in front of pos; pos must not lie inside
+  // the chain.
+  static TLIST_CONSTEXPR void Transfer(TListNodeBase* pos, TListNodeBase* first, TListNodeBase* last) noexcept
+  {
+    if (pos == last)
+      return;
+    TListNodeBase* tail = last->pPrev;
+    first->pPrev->pNext = last;
+    last->pPrev = first->pPrev;
+    tail->pNext = pos;
+    first->pPrev = pos->pPrev;
+    pos->pPrev->pNext = first;
+    pos->pPrev = tail;
+  }
+
+  // Number of nodes from p to the end. Walks from p towards both ends at
+  // once, so the cost is the distance to the nearer end.
+  size_type TailLength(TListNodeBase* p) const noexcept
+  {
+    TListNodeBase* fwd = p;
+    TListNodeBase* back = p;
+    size_type steps = 0;
+    while (true)
+    {
+      if (fwd == &sentinel)
+        return steps;
+      if (back == sentinel.pNext)
+        return count - steps;
+      fwd = fwd->pNext;
+      back = back->pPrev;
+      steps++;
+    }
+  }
+
+  // Merges two null-terminated runs linked through pNext only and stores the
+  // result in out; a holds the earlier elements and wins ties. If comp
+  // throws, out still receives every node of both runs before the exception
+  // propagates.
+  template <class Compare>
+  static void MergeRuns(TListNodeBase*& out, TListNodeBase* a, TListNodeBase* b, Compare& comp)
+  {
+    TListNodeBase head;
+    TListNodeBase* tail = &head;
+    try
+    {
+      while (a != nullptr && b != nullptr)
+        if (comp(Value(b), Value(a)))
+        {
+          tail->pNext = b;
+          tail = b;
+          b = b->pNext;
+        }
+        else
+        {
+          tail->pNext = a;
+          tail = a;
+          a = a->pNext;
+        }
+    }
+    catch (...)
+    {
+      tail->pNext = ConcatChains(a, b);
+      out = head.pNext;
+      throw;
+    }
+    tail->pNext = a != nullptr ? a : b;
+    out = head.pNext;
+  }
+
+  static TListNodeBase* ConcatChains(TListNodeBase* a, TListNodeBase* b) noexcept
+  {
+    if (a == nullptr)
+      return b;
+    TListNodeBase* tail = a;
+    while (tail->pNext != nullptr)
+      tail = tail->pNext;
+    tail->pNext = b;
+    return a;
+  }
+
+  // Chains the non-empty radix buckets in order into chain and returns the
+  // link slot after the last node.
+  static TListNodeBase** JoinBuckets(TListNodeBase*& chain, TListNodeBase* heads[256], TListNodeBase** tails[256]) noexcept
+  {
+    TListNodeBase** tail = &chain;
+    for (int b = 0; b < 256; b++)
+      if (heads[b] != nullptr)
+      {
+        *tail = heads[b];
+        tail = tails[b];
+      }
+    return tail;
+  }
+
+  // Rebuilds the ring and the pPrev links from a null-terminated chain
+  // holding all of the list's nodes.
+  void RelinkChain(TListNodeBase* chain) noexcept
+  {
+    Restructured();
+    TListNodeBase* prev = &sentinel;
+    for (TListNodeBase* p = chain; p != nullptr; p = p->pNext)
+    {
+      prev->pNext = p;
+      p->pPrev = prev;
+      prev = p;
+    }
+    prev->pNext = &sentinel;
+    sentinel.pPrev = prev;
+  }
+
+  TLIST_CONSTEXPR void CheckSameAllocator(const TList& other) const
+  {
+    if constexpr (!TNodeTraits::is_always_equal::value)
+      if (nodeAlloc != other.nodeAlloc)
+        throw std::invalid_argument("TList: cannot splice between lists with different allocators");
+  }
+
+  template <class... Args>
+  TLIST_CONSTEXPR TNode* CreateNode(Args&&... args)
+  {
+    TNode* p = std::addressof(*TNodeTraits::allocate(nodeAlloc, 1));
+    TNodeTraits::construct(nodeAlloc, p);
+    try
+    {
+      TNodeTraits::construct(nodeAlloc, std::addressof(p->value), std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+      TNodeTraits::destroy(nodeAlloc, p);
+      TNodeTraits::deallocate(nodeAlloc, p, 1);
+      throw;
+    }
+    return p;
+  }
+
+  TLIST_CONSTEXPR void DestroyNode(TNode* p) noexcept
+  {
+    TNodeTraits::destroy(nodeAlloc, std::addressof(p->value));
+    TNodeTraits::destroy(nodeAlloc, p);
+    TNodeTraits::deallocate(nodeAlloc, p, 1);
+  }
+
+  // Positional access from a non-const member is the place to bring a stale
+  // skip index up to date and to move the cursor, so that sequential loops
+  // over indices cost O(1) per step.
+  TLIST_CONSTEXPR TListNodeBase* NodeAt(size_type i)
+  {
+    if constexpr (Ranked)
+    {
+      Index().Refresh(&sentinel, count);
+      return const_cast<TListNodeBase*>(Index().Locate(i, &sentinel, count));
+    }
+    TListNodeBase* p = std::as_const(*this).NodeAt(i);
+    pCursor = p;
+    cursorIndex = i;
+    return p;
+  }
+
+  // Read-only: starts from whichever of the head, the tail and the cursor
+  // is nearest, but leaves the cursor where it was.
+  TLIST_CONSTEXPR TListNodeBase* NodeAt(size_type i) const
+  {
+    if constexpr (Ranked)
+      return const_cast<TListNodeBase*>(Index().Locate(i, &sentinel, count));
+    TListNodeBase* p = sentinel.pNext;
+    size_type at = 0;
+    size_type dist = i;
+    if (count - 1 - i < dist)
+    {
+      p = sentinel.pPrev;
+      at = count - 1;
+      dist = count - 1 - i;
+    }
+    if (pCursor != nullptr && (i >= cursorIndex ? i - cursorIndex : cursorIndex - i) < dist)
+    {
+      p = pCursor;
+      at = cursorIndex;
+    }
+    for (; at < i; at++)
+      p = p->pNext;
+    for (; at > i; at--)
+      p = p->pPrev;
+    return p;
+  }
+
+  TLIST_CONSTEXPR void CheckIndex(size_type i) const
+  {
+    if (i >= count)
+      throw std::out_of_range("TList: index out of range");
+  }
+
+  TLIST_CONSTEXPR void CheckNotEmpty() const
+  {
+    if (count == 0)
+      throw std::out_of_range("TList: list is empty");
+  }
+};
+
+template <class T, class Alloc, bool Ranked>
+void swap(TList<T, Alloc, Ranked>& a, TList<T, Alloc, Ranked>& b) noexcept
+{
+  a.swap(b);
+}
+
+// TList with an order-statistic skip index: at, operator[], insert_at and
+// erase_at take O(log n), as do inserts, erases and single-element splices
+// through iterators. Costs a tower pointer per node and about one tower per
+// four nodes.
+template <class T, class Alloc = std::allocator<T>>
+using TRankedList = TList<T, Alloc, true>;
+
+namespace tlist
+{
+  // Merges the sorted lists in [first, last) into one sorted list by
+  // relinking their nodes. A binary heap over the current list heads picks
+  // the next node, so merging N elements from k lists costs O(N log k); on
+  // ties the list that comes first wins, which keeps the merge stable. The
+  // source lists are left empty and must all use equal allocators.
+  template <class ListIt, class Compare>
+  typename std::iterator_traits<ListIt>::value_type merge_k(ListIt first, ListIt last, Compare comp)
+  {
+    using TListType = typename std::iterator_traits<ListIt>::value_type;
+    struct THead
+    {
+      TListType* list;
+      size_t order;
+    };
+
+    std::vector<THead> heap;
+    size_t order = 0;
+    for (ListIt it = first; it != last; ++it, ++order)
+      if (!it->empty())
+        heap.push_back(THead{ &*it, order });
+
+    TListType result(first == last ? typename TListType::allocator_type() : first->get_allocator());
+    if (heap.size() == 1)
+    {
+      result.append(std::move(*heap[0].list));
+      return result;
+    }
+    if (heap.size() == 2)
+    {
+      result.append(std::move(*heap[0].list));
+      result.merge(*heap[1].list, comp);
+      return result;
+    }
+
+    // Heap ordering: a sinks below b when b's head is smaller, or equal and
+    // b's list comes first.
+    auto sinks = [&comp](const THead& a, const THead& b) {
+      if (comp(*b.list->begin(), *a.list->begin()))
+        return true;
+      if (comp(*a.list->begin(), *b.list->begin()))
+        return false;
+      return a.order > b.order;
+    };
+    std::make_heap(heap.begin(), heap.end(), sinks);
+    while (!heap.empty())
+    {
+      std::pop_heap(heap.begin(), heap.end(), sinks);
+      TListType& src = *heap.back().list;
+      result.splice(result.end(), src, src.begin());
+      if (src.empty())
+        heap.pop_back();
+      else
+        std::push_heap(heap.begin(), heap.end(), sinks);
+    }
+    return result;
+  }
+
+  template <class ListIt>
+  typename std::iterator_traits<ListIt>::value_type merge_k(ListIt first, ListIt last)
+  {
+    return merge_k(first, last, std::less<typename std::iterator_traits<ListIt>::value_type::value_type>());
+  }
+
+  // Calls fn on every element of list, splitting the list into equal
+  // segments that run on up to threads threads (0: one per hardware
+  // thread); segments that cannot get a thread run on the calling one. fn
+  // must be safe to call concurrently on distinct elements; the list
+  // itself must not change meanwhile. Supported lists are TList (and
+  // TRankedList, TSmallList), TUnrolledList, TIndexList, TStaticList,
+  // TXorList, TIndexedList and TIntrusiveList. The concurrent lists
+  // (TMpscList, TConcurrentSortedList, TLockCoupledList, TRcuList) are not:
+  // walking them needs a pin or locks that the workers do not take.
+  template <class List, class F>
+  void parallel_for_each(List& list, F fn, size_t threads = 0)
+  {
+    size_t parts = ParallelParts(list.size(), threads);
+    auto points = SplitPoints(list.begin(), list.size(), parts);
+    auto body = [&points, &fn](size_t i) {
+      for (auto it = points[i]; it != points[i + 1]; ++it)
+        fn(*it);
+    };
+    RunParts(parts, body);
+  }
+
+  // Stores fn(x) for every element x of in into the element at the same
+  // position of out, in parallel like parallel_for_each. out must already
+  // have the same size as in and may be in itself.
+  template <class InList, class OutList, class F>
+  void parallel_transform(const InList& in, OutList& out, F fn, size_t threads = 0)
+  {
+    if (in.size() != out.size())
+      throw std::invalid_argument("parallel_transform: lists differ in size");
+    size_t parts = ParallelParts(in.size(), threads);
+    auto from = SplitPoints(in.begin(), in.size(), parts);
+    auto to = SplitPoints(out.begin(), out.size(), parts);
+    auto body = [&from, &to, &fn](size_t i) {
+      auto dst = to[i];
+      for (auto it = from[i]; it != from[i + 1]; ++it, ++dst)
+        *dst = fn(*it);
+    };
+    RunParts(parts, body);
+  }
+}
+
+struct TUnrolledNodeBase
+{
+  TUnrolledNodeBase* pNext;
+  TUnrolledNodeBase* pPrev;
+  unsigned count;
+};
+
+// Default TUnrolledList capacity: as many elements as fit into a 64-byte
+// node next to the two links and the element counter.
+template <class T>
+constexpr size_t TUnrolledDefaultCapacity =
+  sizeof(T) < 64 - sizeof(TUnrolledNodeBase) ? (64 - sizeof(TUnrolledNodeBase)) / sizeof(T) : 1;
+
+template <class T, size_t N>
+struct TUnrolledNode : TUnrolledNodeBase
+{
+  union
+  {
+    T items[N];
+  };
+
+  TUnrolledNode() {}
+  ~TUnrolledNode() {}
+};
+
+template <class T, size_t N, class Alloc>
+class TUnrolledList;
+
+template <class T, size_t N, bool IsConst>
+class TUnrolledIterator
+{
+public:
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = T;
+  using difference_type = std::ptrdiff_t;
+  using pointer = std::conditional_t<IsConst, const T*, T*>;
+  using reference = std::conditional_t<IsConst, const T&, T&>;
+
+  TUnrolledIterator() : pNode(nullptr), idx(0) {}
+
+  template <bool C = IsConst, class = std::enable_if_t<C>>
+  TUnrolledIterator(const TUnrolledIterator<T, N, false>& it) : pNode(it.pNode), idx(it.idx) {}
+
+  reference operator*() const { return static_cast<TUnrolledNode<T, N>*>(pNode)->items[idx]; }
+  pointer operator->() const { return std::addressof(**this); }
+
+  TUnrolledIterator& operator++()
+  {
+    if (++idx >= pNode->count)
+    {
+      pNode = pNode->pNext;
+      idx = 0;
+    }
+    return *this;
+  }
+
+  TUnrolledIterator operator++(int)
+  {
+    TUnrolledIterator tmp = *this;
+    ++*this;
+    return tmp;
+  }
+
+  TUnrolledIterator& operator--()
+  {
+    if (idx == 0)
+    {
+      pNode = pNode->pPrev;
+      idx = pNode->count;
+    }
+    idx--;
+    return *this;
+  }
+
+  TUnrolledIterator operator--(int)
+  {
+    TUnrolledIterator tmp = *this;
+    --*this;
+    return tmp;
+  }
+
+  friend bool operator==(const TUnrolledIterator& a, const TUnrolledIterator& b)
+  {
+    return a.pNode == b.pNode && a.idx == b.idx;
+  }
+
+  friend bool operator!=(const TUnrolledIterator& a, const TUnrolledIterator& b) { return !(a == b); }
+
+private:
+  TUnrolledNodeBase* pNode;
+  size_t idx;
+
+  TUnrolledIterator(const TUnrolledNodeBase* p, size_t i) : pNode(const_cast<TUnrolledNodeBase*>(p)), idx(i) {}
+
+  template <class, size_t, bool> friend class TUnrolledIterator;
+  template <class, size_t, class> friend class TUnrolledList;
+};
+
+// Unrolled linked list: every node holds up to N elements, so a full scan
+// follows one link per N elements instead of one per element.
+//
+// Node policies:
+//  - overflow: inserting at either end of a full node spills into the
+//    neighbour if it has room, otherwise into a fresh node, so push_back and
+//    push_front keep nodes completely full; inserting into the middle of a
+//    full node splits it in half;
+//  - underflow: when erase leaves a node less than half full it is merged
+//    with its successor if both fit into one node, otherwise it borrows
+//    elements from the successor to even them out (the last node merges
+//    into its predecessor instead); empty nodes are freed.
+//
+// insert and erase invalidate iterators into the nodes they touch.
+template <class T, size_t N = TUnrolledDefaultCapacity<T>, class Alloc = std::allocator<T>>
+class TUnrolledList
+{
+  static_assert(N > 0, "TUnrolledList: node capacity must be positive");
+
+  using TNode = TUnrolledNode<T, N>;
+  using TNodeAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<TNode>;
+  using TNodeTraits = std::allocator_traits<TNodeAlloc>;
+
+  static constexpr unsigned MinFill = N / 2;
+
+public:
+  using value_type = T;
+  using allocator_type = Alloc;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using iterator = TUnrolledIterator<T, N, false>;
+  using const_iterator = TUnrolledIterator<T, N, true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  static constexpr size_t node_capacity = N;
+
+  TUnrolledList() : TUnrolledList(Alloc()) {}
+
+  explicit TUnrolledList(const Alloc& alloc) : nodeAlloc(alloc)
+  {
+    Reset();
+  }
+
+  template <class InputIt, class = std::enable_if_t<!std::is_integral<InputIt>::value>>
+  TUnrolledList(InputIt first, InputIt last, const Alloc& alloc = Alloc()) : TUnrolledList(alloc)
+  {
+    for (; first != last; ++first)
+      emplace_back(*first);
+  }
+
+  TUnrolledList(std::initializer_list<T> init, const Alloc& alloc = Alloc())
+    : TUnrolledList(init.begin(), init.end(), alloc) {}
+
+  TUnrolledList(const TUnrolledList& other)
+    : TUnrolledList(other.begin(), other.end(), TNodeTraits::select_on_container_copy_construction(other.nodeAlloc)) {}
+
+  TUnrolledList(TUnrolledList&& other) noexcept : nodeAlloc(std::move(other.nodeAlloc))
+  {
+    Reset();
+    Steal(other);
+  }
+
+  ~TUnrolledList()
+  {
+    clear();
+  }
+
+  TUnrolledList& operator=(const TUnrolledList& other)
+  {
+    if (this != &other)
+    {
+      clear();
+      if constexpr (TNodeTraits::propagate_on_container_copy_assignment::value)
+        nodeAlloc = other.nodeAlloc;
+      for (const T& v : other)
+        push_back(v);
+    }
+    return *this;
+  }
+
+  TUnrolledList& operator=(TUnrolledList&& other) noexcept(TNodeTraits::propagate_on_container_move_assignment::value ||
+                                                           TNodeTraits::is_always_equal::value)
+  {
+    if (this == &other)
+      return *this;
+    clear();
+    if constexpr (TNodeTraits::propagate_on_container_move_assignment::value)
+    {
+      nodeAlloc = std::move(other.nodeAlloc);
+      Steal(other);
+    }
+    else if (nodeAlloc == other.nodeAlloc)
+      Steal(other);
+    else
+    {
+      for (T& v : other)
+        push_back(std::move(v));
+      other.clear();
+    }
+    return *this;
+  }
+
+  allocator_type get_allocator() const { return allocator_type(nodeAlloc); }
+
+  iterator begin() noexcept { return iterator(sentinel.pNext, 0); }
+  const_iterator begin() const noexcept { return const_iterator(sentinel.pNext, 0); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  iterator end() noexcept { return iterator(&sentinel, 0); }
+  const_iterator end() const noexcept { return const_iterator(&sentinel, 0); }
+  const_iterator cend() const noexcept { return end(); }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+  bool empty() const noexcept { return count == 0; }
+  size_type size() const noexcept { return count; }
+
+  // Number of nodes currently allocated.
+  size_type node_count() const noexcept { return nodes; }
+
+  T& front()
+  {
+    CheckNotEmpty();
+    return *begin();
+  }
+
+  const T& front() const
+  {
+    CheckNotEmpty();
+    return *begin();
+  }
+
+  T& back()
+  {
+    CheckNotEmpty();
+    return *--end();
+  }
+
+  const T& back() const
+  {
+    CheckNotEmpty();
+    return *--end();
+  }
+
+  void push_front(const T& value) { emplace(begin(), value); }
+  void push_front(T&& value) { emplace(begin(), std::move(value)); }
+  void push_back(const T& value) { emplace(end(), value); }
+  void push_back(T&& value) { emplace(end(), std::move(value)); }
+
+  template <class... Args>
+  T& emplace_back(Args&&... args)
+  {
+    return *emplace(end(), std::forward<Args>(args)...);
+  }
+
+  template <class... Args>
+  T& emplace_front(Args&&... args)
+  {
+    return *emplace(begin(), std::forward<Args>(args)...);
+  }
+
+  void pop_front()
+  {
+    CheckNotEmpty();
+    erase(begin());
+  }
+
+  void pop_back()
+  {
+    CheckNotEmpty();
+    erase(--end());
+  }
+
+  iterator insert(const_iterator pos, const T& value) { return emplace(pos, value); }
+  iterator insert(const_iterator pos, T&& value) { return emplace(pos, std::move(value)); }
+
+  template <class... Args>
+  iterator emplace(const_iterator pos, Args&&... args)
+  {
+    // Build the value before any element moves: args may refer to an
+    // element of this list (u.push_front(u.front())).
+    T value(std::forward<Args>(args)...);
+    TNode* n;
+    size_t i;
+    if (pos.pNode == &sentinel)
+    {
+      if (sentinel.pPrev == &sentinel)
+        NewNode(&sentinel);
+      n = AsNode(sentinel.pPrev);
+      i = n->count;
+    }
+    else
+    {
+      n = AsNode(pos.pNode);
+      i = pos.idx;
+    }
+
+    if (n->count == N)
+    {
+      if (i == N)
+      {
+        if (n->pNext != &sentinel && n->pNext->count < N)
+          n = AsNode(n->pNext);
+        else
+          n = NewNode(n->pNext);
+        i = 0;
+      }
+      else if (i == 0)
+      {
+        if (n->pPrev != &sentinel && n->pPrev->count < N)
+          n = AsNode(n->pPrev);
+        else
+          n = NewNode(n);
+        i = n->count;
+      }
+      else
+      {
+        TNode* upper = NewNode(n->pNext);
+        Relocate(upper, 0, n, N / 2, N - N / 2);
+        upper->count = N - N / 2;
+        n->count = N / 2;
+        if (i > N / 2)
+        {
+          i -= N / 2;
+          n = upper;
+        }
+      }
+    }
+
+    OpenGap(n, i);
+    try
+    {
+      TNodeTraits::construct(nodeAlloc, n->items + i, std::move(value));
+    }
+    catch (...)
+    {
+      CloseGap(n, i);
+      if (n->count == 0)
+        FreeNode(n);
+      throw;
+    }
+    count++;
+    return iterator(n, i);
+  }
+
+  iterator erase(const_iterator pos)
+  {
+    TNode* n = AsNode(pos.pNode);
+    size_t i = pos.idx;
+    TNodeTraits::destroy(nodeAlloc, n->items + i);
+    CloseGap(n, i);
+    count--;
+
+    if (n->count == 0)
+    {
+      TUnrolledNodeBase* next = n->pNext;
+      FreeNode(n);
+      return iterator(next, 0);
+    }
+    if (n->count < MinFill)
+    {
+      TUnrolledNodeBase* next = n->pNext;
+      TUnrolledNodeBase* prev = n->pPrev;
+      if (next != &sentinel)
+      {
+        TNode* nx = AsNode(next);
+        if (n->count + nx->count <= N)
+        {
+          Relocate(n, n->count, nx, 0, nx->count);
+          n->count += nx->count;
+          nx->count = 0;
+          FreeNode(nx);
+        }
+        else
+        {
+          size_t k = (nx->count - n->count) / 2;
+          Relocate(n, n->count, nx, 0, k);
+          n->count += static_cast<unsigned>(k);
+          ShiftDown(nx, k);
+        }
+      }
+      else if (prev != &sentinel && prev->count + n->count <= N)
+      {
+        TNode* pv = AsNode(prev);
+        Relocate(pv, pv->count, n, 0, n->count);
+        i += pv->count;
+        pv->count += n->count;
+        n->count = 0;
+        FreeNode(n);
+        n = pv;
+      }
+    }
+    if (i == n->count)
+      return iterator(n->pNext, 0);
+    return iterator(n, i);
+  }
+
+  iterator erase(const_iterator first, const_iterator last)
+  {
+    // Element positions shift under erase, so count the range first.
+    size_t k = 0;
+    for (const_iterator it = first; it != last; ++it)
+      k++;
+    iterator it(first.pNode, first.idx);
+    for (; k > 0; k--)
+      it = erase(it);
+    return it;
+  }
+
+  void clear() noexcept
+  {
+    TUnrolledNodeBase* p = sentinel.pNext;
+    while (p != &sentinel)
+    {
+      TNode* n = AsNode(p);
+      p = p->pNext;
+      for (unsigned i = 0; i < n->count; i++)
+        TNodeTraits::destroy(nodeAlloc, n->items + i);
+      TNodeTraits::destroy(nodeAlloc, n);
+      TNodeTraits::deallocate(nodeAlloc, n, 1);
+    }
+    Reset();
+  }
+
+  void swap(TUnrolledList& other) noexcept
+  {
+    if constexpr (TNodeTraits::propagate_on_container_swap::value)
+    {
+      using std::swap;
+      swap(nodeAlloc, other.nodeAlloc);
+    }
+    TUnrolledNodeBase tmp;
+    MoveChain(tmp, sentinel);
+    MoveChain(sentinel, other.sentinel);
+    MoveChain(other.sentinel, tmp);
+    std::swap(count, other.count);
+    std::swap(nodes, other.nodes);
+  }
+
+  friend bool operator==(const TUnrolledList& a, const TUnrolledList& b)
+  {
+    return a.count == b.count && std::equal(a.begin(), a.end(), b.begin());
+  }
+
+  friend bool operator!=(const TUnrolledList& a, const TUnrolledList& b) { return !(a == b); }
+
+  friend std::ostream& operator<<(std::ostream& os, const TUnrolledList& l)
+  {
+    os << '{';
+    for (auto it = l.begin(); it != l.end(); ++it)
+      os << (it == l.begin() ? "" : ", ") << *it;
+    return os << '}';
+  }
+
+private:
+  TUnrolledNodeBase sentinel;
+  size_type count;
+  size_type nodes;
+  TNodeAlloc nodeAlloc;
+
+  static TNode* AsNode(TUnrolledNodeBase* p) { return static_cast<TNode*>(p); }
+
+  void Reset() noexcept
+  {
+    sentinel.pNext = sentinel.pPrev = &sentinel;
+    sentinel.count = 0;
+    count = 0;
+    nodes = 0;
+  }
+
+  static void MoveChain(TUnrolledNodeBase& to, TUnrolledNodeBase& from) noexcept
+  {
+    to.count = 0;
+    if (from.pNext == &from)
+    {
+      to.pNext = to.pPrev = &to;
+      return;
+    }
+    to.pNext = from.pNext;
+    to.pPrev = from.pPrev;
+    to.pNext->pPrev = &to;
+    to.pPrev->pNext = &to;
+    from.pNext = from.pPrev = &from;
+  }
+
+  void Steal(TUnrolledList& other) noexcept
+  {
+    MoveChain(sentinel, other.sentinel);
+    count = other.count;
+    nodes = other.nodes;
+    other.count = 0;
+    other.nodes = 0;
+  }
+
+  // Allocates an empty node and links it in front of pos.
+  TNode* NewNode(TUnrolledNodeBase* pos)
+  {
+    TNode* n = std::addressof(*TNodeTraits::allocate(nodeAlloc, 1));
+    TNodeTraits::construct(nodeAlloc, n);
+    n->count = 0;
+    n->pNext = pos;
+    n->pPrev = pos->pPrev;
+    pos->pPrev->pNext = n;
+    pos->pPrev = n;
+    nodes++;
+    return n;
+  }
+
+  // Unlinks and frees a node whose elements have already been destroyed or
+  // moved out.
+  void FreeNode(TNode* n) noexcept
+  {
+    n->pPrev->pNext = n->pNext;
+    n->pNext->pPrev = n->pPrev;
+    TNodeTraits::destroy(nodeAlloc, n);
+    TNodeTraits::deallocate(nodeAlloc, n, 1);
+    nodes--;
+  }
+
+  // Moves k elements from src[si..] into raw slots dst[di..] of another node.
+  void Relocate(TNode* dst, size_t di, TNode* src, size_t si, size_t k)
+  {
+    for (size_t j = 0; j < k; j++)
+    {
+      TNodeTraits::construct(nodeAlloc, dst->items + di + j, std::move(src->items[si + j]));
+      TNodeTraits::destroy(nodeAlloc, src->items + si + j);
+    }
+  }
+
+  // Makes slot i of n raw by shifting the tail one slot up; count grows.
+  void OpenGap(TNode* n, size_t i)
+  {
+    for (size_t j = n->count; j > i; j--)
+    {
+      TNodeTraits::construct(nodeAlloc, n->items + j, std::move(n->items[j - 1]));
+      TNodeTraits::destroy(nodeAlloc, n->items + j - 1);
+    }
+    n->count++;
+  }
+
+  // Inverse of OpenGap: slot i is raw, the tail moves one slot down.
+  void CloseGap(TNode* n, size_t i)
+  {
+    for (size_t j = i + 1; j < n->count; j++)
+    {
+      TNodeTraits::construct(nodeAlloc, n->items + j - 1, std::move(n->items[j]));
+      TNodeTraits::destroy(nodeAlloc, n->items + j);
+    }
+    n->count--;
+  }
+
+  // Drops the first k (already moved-out) slots of n.
+  void ShiftDown(TNode* n, size_t k)
+  {
+    for (size_t j = k; j < n->count; j++)
+    {
+      TNodeTraits::construct(nodeAlloc, n->items + j - k, std::move(n->items[j]));
+      TNodeTraits::destroy(nodeAlloc, n->items + j);
+    }
+    n->count -= static_cast<unsigned>(k);
+  }
+
+  void CheckNotEmpty() const
+  {
+    if (count == 0)
+      throw std::out_of_range("TUnrolledList: list is empty");
+  }
+};
+
+template <class T, size_t N, class Alloc>
+void swap(TUnrolledList<T, N, Alloc>& a, TUnrolledList<T, N, Alloc>& b) noexcept
+{
+  a.swap(b);
+}
+
+// Node of an index-linked list. Links are 32-bit slot numbers into the
+// list's node array rather than pointers; slot 0 is the sentinel.
+template <class T>
+struct TIndexNode
+{
+  uint32_t next;
+  uint32_t prev;
+  union
+  {
+    T value;
+  };
+
+  TIndexNode() {}
+  ~TIndexNode() {}
+};
+
+template <class T, class Alloc>
+class TIndexList;
+
+// Iterator over an index-linked list (TIndexList, TStaticList): the owning
+// list plus a slot number, so it stays valid when the node array is
+// reallocated. The list exposes its slots through NodeAt().
+template <class TContainer, bool IsConst>
+class TIndexListIterator
+{
+  using TOwner = std::conditional_t<IsConst, const TContainer, TContainer>;
+
+public:
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = typename TContainer::value_type;
+  using difference_type = std::ptrdiff_t;
+  using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+  using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+
+  TIndexListIterator() : pList(nullptr), idx(0) {}
+
+  template <bool C = IsConst, class = std::enable_if_t<C>>
+  TIndexListIterator(const TIndexListIterator<TContainer, false>& it) : pList(it.pList), idx(it.idx) {}
+
+  reference operator*() const { return pList->NodeAt(idx).value; }
+  pointer operator->() const { return std::addressof(**this); }
+
+  TIndexListIterator& operator++()
+  {
+    idx = pList->NodeAt(idx).next;
+    return *this;
+  }
+
+  TIndexListIterator operator++(int)
+  {
+    TIndexListIterator tmp = *this;
+    ++*this;
+    return tmp;
+  }
+
+  TIndexListIterator& operator--()
+  {
+    idx = pList->NodeAt(idx).prev;
+    return *this;
+  }
+
+  TIndexListIterator operator--(int)
+  {
+    TIndexListIterator tmp = *this;
+    --*this;
+    return tmp;
+  }
+
+  // Slot of the element; stable for the element's lifetime.
+  uint32_t index() const noexcept { return idx; }
+
+  friend bool operator==(const TIndexListIterator& a, const TIndexListIterator& b) { return a.idx == b.idx; }
+  friend bool operator!=(const TIndexListIterator& a, const TIndexListIterator& b) { return a.idx != b.idx; }
+
+private:
+  TOwner* pList;
+  uint32_t idx;
+
+  TIndexListIterator(TOwner* l, uint32_t i) : pList(l), idx(i) {}
+
+  template <class, bool> friend class TIndexListIterator;
+  friend TContainer;
+};
+
+// Doubly linked list whose nodes live in one growable array and link to each
+// other through uint32_t slot numbers. Compared to TList this halves the link
+// overhead on 64-bit targets and keeps the nodes dense in memory. Freed slots
+// are recycled through a free list threaded over their next links. Growing
+// the array moves the elements, so pointers and references into the list are
+// invalidated by inserts that reallocate; iterators and slot numbers are not.
+template <class T, class Alloc = std::allocator<T>>
+class TIndexList
+{
+  using TNode = TIndexNode<T>;
+  using TNodeAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<TNode>;
+  using TNodeTraits = std::allocator_traits<TNodeAlloc>;
+
+  static constexpr uint32_t Nil = 0xffffffffu;
+
+public:
+  using value_type = T;
+  using allocator_type = Alloc;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using iterator = TIndexListIterator<TIndexList, false>;
+  using const_iterator = TIndexListIterator<TIndexList, true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  TIndexList() : TIndexList(Alloc()) {}
+
+  // The node array is allocated on first insertion.
+  explicit TIndexList(const Alloc& alloc) noexcept
+    : nodeAlloc(alloc), pNodes(nullptr), cap(0), used(0), freeHead(Nil), count(0) {}
+
+  template <class InputIt, class = std::enable_if_t<!std::is_integral<InputIt>::value>>
+  TIndexList(InputIt first, InputIt last, const Alloc& alloc = Alloc()) : TIndexList(alloc)
+  {
+    for (; first != last; ++first)
+      emplace_back(*first);
+  }
+
+  TIndexList(std::initializer_list<T> init, const Alloc& alloc = Alloc())
+    : TIndexList(init.begin(), init.end(), alloc) {}
+
+  TIndexList(const TIndexList& other)
+    : TIndexList(TNodeTraits::select_on_container_copy_construction(other.nodeAlloc))
+  {
+    reserve(other.count);
+    for (const T& v : other)
+      push_back(v);
+  }
+
+  TIndexList(TIndexList&& other) noexcept
+    : nodeAlloc(std::move(other.nodeAlloc)), pNodes(nullptr), cap(0), used(0), freeHead(Nil), count(0)
+  {
+    Steal(other);
+  }
+
+  ~TIndexList()
+  {
+    Release();
+  }
+
+  TIndexList& operator=(const TIndexList& other)
+  {
+    if (this != &other)
+    {
+      clear();
+      if constexpr (TNodeTraits::propagate_on_container_copy_assignment::value)
+      {
+        // The array came from the old allocator and goes back to it.
+        if (nodeAlloc != other.nodeAlloc)
+          Release();
+        nodeAlloc = other.nodeAlloc;
+      }
+      reserve(other.count);
+      for (const T& v : other)
+        push_back(v);
+    }
+    return *this;
+  }
+
+  TIndexList& operator=(TIndexList&& other) noexcept(TNodeTraits::propagate_on_container_move_assignment::value ||
+                                                     TNodeTraits::is_always_equal::value)
+  {
+    if (this == &other)
+      return *this;
+    if constexpr (TNodeTraits::propagate_on_container_move_assignment::value)
+    {
+      Release();
+      nodeAlloc = std::move(other.nodeAlloc);
+      Steal(other);
+    }
+    else if (nodeAlloc == other.nodeAlloc)
+    {
+      Release();
+      Steal(other);
+    }
+    else
+    {
+      // The array belongs to other's allocator, so the elements move one by one.
+      clear();
+      reserve(other.count);
+      for (T& v : other)
+        push_back(std::move(v));
+      other.clear();
+    }
+    return *this;
+  }
+
+  allocator_type get_allocator() const { return allocator_type(nodeAlloc); }
+
+  iterator begin() noexcept { return iterator(this, FirstSlot()); }
+  const_iterator begin() const noexcept { return const_iterator(this, FirstSlot()); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  iterator end() noexcept { return iterator(this, 0); }
+  const_iterator end() const noexcept { return const_iterator(this, 0); }
+  const_iterator cend() const noexcept { return end(); }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+  bool empty() const noexcept { return count == 0; }
+  size_type size() const noexcept { return count; }
+
+  // Number of elements the node array can hold without reallocating.
+  size_type capacity() const noexcept { return cap == 0 ? 0 : cap - 1; }
+
+  void reserve(size_type n)
+  {
+    if (n > MaxElements())
+      throw std::length_error("TIndexList: too many elements");
+    if (n + 1 > cap)
+      Reserve(static_cast<uint32_t>(n + 1));
+  }
+
+  T& front()
+  {
+    CheckNotEmpty();
+    return pNodes[Head().next].value;
+  }
+
+  const T& front() const
+  {
+    CheckNotEmpty();
+    return pNodes[Head().next].value;
+  }
+
+  T& back()
+  {
+    CheckNotEmpty();
+    return pNodes[Head().prev].value;
+  }
+
+  const T& back() const
+  {
+    CheckNotEmpty();
+    return pNodes[Head().prev].value;
+  }
+
+  void push_front(const T& value) { emplace(begin(), value); }
+  void push_front(T&& value) { emplace(begin(), std::move(value)); }
+  void push_back(const T& value) { emplace(end(), value); }
+  void push_back(T&& value) { emplace(end(), std::move(value)); }
+
+  template <class... Args>
+  T& emplace_front(Args&&... args)
+  {
+    return *emplace(begin(), std::forward<Args>(args)...);
+  }
+
+  template <class... Args>
+  T& emplace_back(Args&&... args)
+  {
+    return *emplace(end(), std::forward<Args>(args)...);
+  }
+
+  void pop_front()
+  {
+    CheckNotEmpty();
+    erase(begin());
+  }
+
+  void pop_back()
+  {
+    CheckNotEmpty();
+    erase(iterator(this, Head().prev));
+  }
+
+  iterator insert(const_iterator pos, const T& value) { return emplace(pos, value); }
+  iterator insert(const_iterator pos, T&& value) { return emplace(pos, std::move(value)); }
+
+  template <class... Args>
+  iterator emplace(const_iterator pos, Args&&... args)
+  {
+    uint32_t i;
+    if (freeHead == Nil && used == cap)
+    {
+      // Like std::vector: the new value is built in the new array while the
+      // old one, which args may point into, is still alive.
+      uint32_t newCap = GrownCapacity();
+      TNode* p = AllocateArray(newCap);
+      i = pNodes == nullptr ? 1 : used;
+      try
+      {
+        TNodeTraits::construct(nodeAlloc, std::addressof(p[i].value), std::forward<Args>(args)...);
+      }
+      catch (...)
+      {
+        FreeArray(p, newCap);
+        throw;
+      }
+      try
+      {
+        Adopt(p, newCap);
+      }
+      catch (...)
+      {
+        TNodeTraits::destroy(nodeAlloc, std::addressof(p[i].value));
+        FreeArray(p, newCap);
+        throw;
+      }
+      used++;
+    }
+    else
+    {
+      i = AcquireSlot();
+      try
+      {
+        TNodeTraits::construct(nodeAlloc, std::addressof(pNodes[i].value), std::forward<Args>(args)...);
+      }
+      catch (...)
+      {
+        ReleaseSlot(i);
+        throw;
+      }
+    }
+    uint32_t at = pos.idx;
+    TNode& n = pNodes[i];
+    n.next = at;
+    n.prev = pNodes[at].prev;
+    pNodes[n.prev].next = i;
+    pNodes[at].prev = i;
+    count++;
+    return iterator(this, i);
+  }
+
+  iterator erase(const_iterator pos)
+  {
+    uint32_t i = pos.idx;
+    TNode& n = pNodes[i];
+    uint32_t next = n.next;
+    pNodes[n.prev].next = n.next;
+    pNodes[n.next].prev = n.prev;
+    TNodeTraits::destroy(nodeAlloc, std::addressof(n.value));
+    ReleaseSlot(i);
+    count--;
+    return iterator(this, next);
+  }
+
+  iterator erase(const_iterator first, const_iterator last)
+  {
+    while (first != last)
+      first = erase(first);
+    return iterator(this, last.idx);
+  }
+
+  // Destroys all elements but keeps the node array for reuse.
+  void clear() noexcept
+  {
+    if (pNodes == nullptr)
+      return;
+    for (uint32_t i = Head().next; i != 0; i = pNodes[i].next)
+      TNodeTraits::destroy(nodeAlloc, std::addressof(pNodes[i].value));
+    Head().next = Head().prev = 0;
+    used = 1;
+    freeHead = Nil;
+    count = 0;
+  }
+
+  void swap(TIndexList& other) noexcept
+  {
+    using std::swap;
+    if constexpr (TNodeTraits::propagate_on_container_swap::value)
+      swap(nodeAlloc, other.nodeAlloc);
+    swap(pNodes, other.pNodes);
+    swap(cap, other.cap);
+    swap(used, other.used);
+    swap(freeHead, other.freeHead);
+    swap(count, other.count);
+  }
+
+  friend bool operator==(const TIndexList& a, const TIndexList& b)
+  {
+    return a.count == b.count && std::equal(a.begin(), a.end(), b.begin());
+  }
+
+  friend bool operator!=(const TIndexList& a, const TIndexList& b) { return !(a == b); }
+
+  friend std::ostream& operator<<(std::ostream& os, const TIndexList& l)
+  {
+    os << '{';
+    for (auto it = l.begin(); it != l.end(); ++it)
+      os << (it == l.begin() ? "" : ", ") << *it;
+    return os << '}';
+  }
+
+private:
+  TNodeAlloc nodeAlloc;
+  TNode* pNodes;
+  uint32_t cap;
+  uint32_t used;
+  uint32_t freeHead;
+  size_type count;
+
+  friend iterator;
+  friend const_iterator;
+
+  static constexpr size_type MaxElements() { return Nil - 1; }
+
+  TNode& NodeAt(uint32_t i) noexcept { return pNodes[i]; }
+  const TNode& NodeAt(uint32_t i) const noexcept { return pNodes[i]; }
+
+  // Only valid once the node array exists, i.e. when the list is not empty.
+  TNode& Head() noexcept { return pNodes[0]; }
+  const TNode& Head() const noexcept { return pNodes[0]; }
+
+  uint32_t FirstSlot() const noexcept { return pNodes == nullptr ? 0 : pNodes[0].next; }
+
+  // Slot for a new element; the caller has made sure one is free.
+  uint32_t AcquireSlot() noexcept
+  {
+    if (freeHead != Nil)
+    {
+      uint32_t i = freeHead;
+      freeHead = pNodes[i].next;
+      return i;
+    }
+    return used++;
+  }
+
+  void ReleaseSlot(uint32_t i) noexcept
+  {
+    pNodes[i].next = freeHead;
+    freeHead = i;
+  }
+
+  // Capacity to grow to when the array is full.
+  uint32_t GrownCapacity() const
+  {
+    if (cap > MaxElements())
+      throw std::length_error("TIndexList: too many elements");
+    uint64_t grown = cap < 8 ? 8 : uint64_t(cap) * 2;
+    return static_cast<uint32_t>(grown > Nil ? Nil : grown);
+  }
+
+  // A new array of n slots with no values in it.
+  TNode* AllocateArray(uint32_t n)
+  {
+    TNode* p = std::addressof(*TNodeTraits::allocate(nodeAlloc, n));
+    for (uint32_t i = 0; i < n; i++)
+      TNodeTraits::construct(nodeAlloc, p + i);
+    return p;
+  }
+
+  void FreeArray(TNode* p, uint32_t n) noexcept
+  {
+    for (uint32_t i = 0; i < n; i++)
+      TNodeTraits::destroy(nodeAlloc, p + i);
+    TNodeTraits::deallocate(nodeAlloc, p, n);
+  }
+
+  // Moves the list into p, an array of newCap slots from AllocateArray, and
+  // frees the old array. Links are copied verbatim for every slot in use,
+  // values only for linked slots. If copying a value throws, the values
+  // already copied into p are destroyed and the list is left as it was.
+  void Adopt(TNode* p, uint32_t newCap)
+  {
+    if (pNodes == nullptr)
+    {
+      p[0].next = p[0].prev = 0;
+      used = 1;
+    }
+    else
+    {
+      uint32_t i = pNodes[0].next;
+      try
+      {
+        for (; i != 0; i = pNodes[i].next)
+          TNodeTraits::construct(nodeAlloc, std::addressof(p[i].value), std::move_if_noexcept(pNodes[i].value));
+      }
+      catch (...)
+      {
+        for (uint32_t j = pNodes[0].next; j != i; j = pNodes[j].next)
+          TNodeTraits::destroy(nodeAlloc, std::addressof(p[j].value));
+        throw;
+      }
+      for (uint32_t j = 0; j < used; j++)
+      {
+        p[j].next = pNodes[j].next;
+        p[j].prev = pNodes[j].prev;
+      }
+      for (uint32_t j = pNodes[0].next; j != 0; j = pNodes[j].next)
+        TNodeTraits::destroy(nodeAlloc, std::addressof(pNodes[j].value));
+      FreeArray(pNodes, cap);
+    }
+    pNodes = p;
+    cap = newCap;
+  }
+
+  void Reserve(uint32_t newCap)
+  {
+    TNode* p = AllocateArray(newCap);
+    try
+    {
+      Adopt(p, newCap);
+    }
+    catch (...)
+    {
+      FreeArray(p, newCap);
+      throw;
+    }
+  }
+
+  void Release() noexcept
+  {
+    if (pNodes == nullptr)
+      return;
+    clear();
+    FreeArray(pNodes, cap);
+    pNodes = nullptr;
+    cap = used = 0;
+    freeHead = Nil;
+  }
+
+  // Takes other's array; this list must hold none.
+  void Steal(TIndexList& other) noexcept
+  {
+    pNodes = other.pNodes;
+    cap = other.cap;
+    used = other.used;
+    freeHead = other.freeHead;
+    count = other.count;
+    other.pNodes = nullptr;
+    other.cap = other.used = 0;
+    other.freeHead = Nil;
+    other.count = 0;
+  }
+
+  void CheckNotEmpty() const
+  {
+    if (count == 0)
+      throw std::out_of_range("TIndexList: list is empty");
+  }
+};
+
+template <class T, class Alloc>
+void swap(TIndexList<T, Alloc>& a, TIndexList<T, Alloc>& b) noexcept
+{
+  a.swap(b);
+}
+
+// Doubly linked list of at most Capacity elements stored in a node array
+// inside the object, linked by slot number like TIndexList and sharing its
+// node layout and iterators. It never calls an allocator: inserting into a
+// full list throws std::length_error and leaves the list unchanged, and
+// every insert and erase is O(1) with no hidden growth step. Pointers and
+// references to elements stay valid until the element is erased. Copies
+// and moves go element by element.
+template <class T, size_t Capacity>
+class TStaticList
+{
+  static_assert(Capacity > 0 && Capacity < 0xffffffffu - 1, "TStaticList: capacity out of range");
+
+  using TNode = TIndexNode<T>;
+
+  static constexpr uint32_t Nil = 0xffffffffu;
+
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using iterator = TIndexListIterator<TStaticList, false>;
+  using const_iterator = TIndexListIterator<TStaticList, true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  TStaticList() noexcept
+  {
+    nodes[0].next = nodes[0].prev = 0;
+  }
+
+  template <class InputIt, class = std::enable_if_t<!std::is_integral<InputIt>::value>>
+  TStaticList(InputIt first, InputIt last) : TStaticList()
+  {
+    for (; first != last; ++first)
+      emplace_back(*first);
+  }
+
+  TStaticList(std::initializer_list<T> init) : TStaticList(init.begin(), init.end()) {}
+
+  TStaticList(const TStaticList& other) : TStaticList(other.begin(), other.end()) {}
+
+  TStaticList(TStaticList&& other) : TStaticList()
+  {
+    for (T& v : other)
+      push_back(std::move(v));
+  }
+
+  ~TStaticList()
+  {
+    clear();
+  }
+
+  TStaticList& operator=(const TStaticList& other)
+  {
+    if (this != &other)
+      AssignRange(other.begin(), other.end());
+    return *this;
+  }
+
+  TStaticList& operator=(TStaticList&& other)
+  {
+    if (this != &other)
+      AssignRange(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+    return *this;
+  }
+
+  TStaticList& operator=(std::initializer_list<T> init)
+  {
+    AssignRange(init.begin(), init.end());
+    return *this;
+  }
+
+  iterator begin() noexcept { return iterator(this, nodes[0].next); }
+  const_iterator begin() const noexcept { return const_iterator(this, nodes[0].next); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  iterator end() noexcept { return iterator(this, 0); }
+  const_iterator end() const noexcept { return const_iterator(this, 0); }
+  const_iterator cend() const noexcept { return end(); }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+  bool empty() const noexcept { return count == 0; }
+  bool full() const noexcept { return count == Capacity; }
+  size_type size() const noexcept { return count; }
+  static constexpr size_type capacity() noexcept { return Capacity; }
+  static constexpr size_type max_size() noexcept { return Capacity; }
+
+  T& front()
+  {
+    CheckNotEmpty();
+    return nodes[nodes[0].next].value;
+  }
+
+  const T& front() const
+  {
+    CheckNotEmpty();
+    return nodes[nodes[0].next].value;
+  }
+
+  T& back()
+  {
+    CheckNotEmpty();
+    return nodes[nodes[0].prev].value;
+  }
+
+  const T& back() const
+  {
+    CheckNotEmpty();
+    return nodes[nodes[0].prev].value;
+  }
+
+  void push_front(const T& value) { emplace(begin(), value); }
+  void push_front(T&& value) { emplace(begin(), std::move(value)); }
+  void push_back(const T& value) { emplace(end(), value); }
+  void push_back(T&& value) { emplace(end(), std::move(value)); }
+
+  template <class... Args>
+  T& emplace_front(Args&&... args)
+  {
+    return *emplace(begin(), std::forward<Args>(args)...);
+  }
+
+  template <class... Args>
+  T& emplace_back(Args&&... args)
+  {
+    return *emplace(end(), std::forward<Args>(args)...);
+  }
+
+  void pop_front()
+  {
+    CheckNotEmpty();
+    erase(begin());
+  }
+
+  void pop_back()
+  {
+    CheckNotEmpty();
+    erase(iterator(this, nodes[0].prev));
+  }
+
+  iterator insert(const_iterator pos, const T& value) { return emplace(pos, value); }
+  iterator insert(const_iterator pos, T&& value) { return emplace(pos, std::move(value)); }
+
+  template <class... Args>
+  iterator emplace(const_iterator pos, Args&&... args)
+  {
+    uint32_t i = AcquireSlot();
+    try
+    {
+      ::new (static_cast<void*>(std::addressof(nodes[i].value))) T(std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+      ReleaseSlot(i);
+      throw;
+    }
+    uint32_t at = pos.idx;
+    TNode& n = nodes[i];
+    n.next = at;
+    n.prev = nodes[at].prev;
+    nodes[n.prev].next = i;
+    nodes[at].prev = i;
+    count++;
+    return iterator(this, i);
+  }
+
+  iterator erase(const_iterator pos) noexcept
+  {
+    uint32_t i = pos.idx;
+    TNode& n = nodes[i];
+    uint32_t next = n.next;
+    nodes[n.prev].next = n.next;
+    nodes[n.next].prev = n.prev;
+    n.value.~T();
+    ReleaseSlot(i);
+    count--;
+    return iterator(this, next);
+  }
+
+  iterator erase(const_iterator first, const_iterator last) noexcept
+  {
+    while (first != last)
+      first = erase(first);
+    return iterator(this, last.idx);
+  }
+
+  void clear() noexcept
+  {
+    for (uint32_t i = nodes[0].next; i != 0; i = nodes[i].next)
+      nodes[i].value.~T();
+    nodes[0].next = nodes[0].prev = 0;
+    used = 1;
+    freeHead = Nil;
+    count = 0;
+  }
+
+  void swap(TStaticList& other)
+  {
+    if (this == &other)
+      return;
+    TStaticList tmp(std::move(other));
+    other = std::move(*this);
+    *this = std::move(tmp);
+  }
+
+  friend bool operator==(const TStaticList& a, const TStaticList& b)
+  {
+    return a.count == b.count && std::equal(a.begin(), a.end(), b.begin());
+  }
+
+  friend bool operator!=(const TStaticList& a, const TStaticList& b) { return !(a == b); }
+
+  friend std::ostream& operator<<(std::ostream& os, const TStaticList& l)
+  {
+    os << '{';
+    for (auto it = l.begin(); it != l.end(); ++it)
+      os << (it == l.begin() ? "" : ", ") << *it;
+    return os << '}';
+  }
+
+private:
+  // Slot 0 is the sentinel; slots below used have been handed out at least
+  // once, freed ones are threaded through freeHead.
+  TNode nodes[Capacity + 1];
+  uint32_t used = 1;
+  uint32_t freeHead = Nil;
+  size_type count = 0;
+
+  friend iterator;
+  friend const_iterator;
+
+  TNode& NodeAt(uint32_t i) noexcept { return nodes[i]; }
+  const TNode& NodeAt(uint32_t i) const noexcept { return nodes[i]; }
+
+  uint32_t AcquireSlot()
+  {
+    if (freeHead != Nil)
+    {
+      uint32_t i = freeHead;
+      freeHead = nodes[i].next;
+      return i;
+    }
+    if (used == Capacity + 1)
+      throw std::length_error("TStaticList: capacity exceeded");
+    return used++;
+  }
+
+  void ReleaseSlot(uint32_t i) noexcept
+  {
+    nodes[i].next = freeHead;
+    freeHead = i;
+  }
+
+  // Assigns over existing elements and only constructs or destroys the
+  // difference in length.
+  template <class InputIt>
+  void AssignRange(InputIt first, InputIt last)
+  {
+    iterator it = begin();
+    for (; it != end() && first != last; ++it, ++first)
+      *it = *first;
+    if (first == last)
+      erase(it, end());
+    else
+      for (; first != last; ++first)
+        emplace_back(*first);
+  }
+
+  void CheckNotEmpty() const
+  {
+    if (count == 0)
+      throw std::out_of_range("TStaticList: list is empty");
+  }
+};
+
+template <class T, size_t Capacity>
+void swap(TStaticList<T, Capacity>& a, TStaticList<T, Capacity>& b)
+{
+  a.swap(b);
+}
+
+// Slab pool of equally sized blocks. Blocks are carved out of slabs of
+// nodesPerSlab blocks each and freed blocks are threaded onto an intrusive
+// free list, so a list whose size is roughly stable stops touching the heap
+// once the pool has warmed up. The block size is fixed by the first request.
+// Not thread-safe.
+class TNodePool
+{
+public:
+  struct TStats
+  {
+    size_t slabs;
+    size_t freeNodes;
+    size_t liveNodes;
+    size_t highWater;
+  };
+
+  explicit TNodePool(size_t nodesPerSlab = 256)
+    : perSlab(nodesPerSlab == 0 ? 1 : nodesPerSlab), objSize(0), objAlign(0), blockSize(0),
+      pFree(nullptr), freeCount(0), liveCount(0), highWater(0) {}
+
+  TNodePool(const TNodePool&) = delete;
+  TNodePool& operator=(const TNodePool&) = delete;
+
+  ~TNodePool()
+  {
+    for (char* slab : slabs)
+      FreeSlab(slab);
+  }
+
+  // True if blocks of this pool can hold an object of the given size and
+  // alignment. The first query fixes the block geometry.
+  bool Accepts(size_t size, size_t align)
+  {
+    if (objSize == 0)
+    {
+      objSize = size;
+      objAlign = std::max(align, alignof(TFreeBlock));
+      blockSize = (std::max(size, sizeof(TFreeBlock)) + objAlign - 1) / objAlign * objAlign;
+    }
+    return size == objSize && align <= objAlign;
+  }
+
+  void* Allocate()
+  {
+    if (pFree == nullptr)
+      AddSlab();
+    TFreeBlock* p = pFree;
+    pFree = p->pNext;
+    freeCount--;
+    liveCount++;
+    highWater = std::max(highWater, liveCount);
+    return p;
+  }
+
+  void Deallocate(void* p) noexcept
+  {
+    TFreeBlock* b = static_cast<TFreeBlock*>(p);
+    b->pNext = pFree;
+    pFree = b;
+    freeCount++;
+    liveCount--;
+  }
+
+  TStats stats() const { return TStats{ slabs.size(), freeCount, liveCount, highWater }; }
+
+  // Returns slabs whose blocks are all on the free list to the heap and
+  // reports how many were released.
+  size_t shrink_to_fit()
+  {
+    if (freeCount < perSlab)
+      return 0;
+    std::vector<char*> sorted(slabs);
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<size_t> freeInSlab(sorted.size(), 0);
+    for (TFreeBlock* p = pFree; p != nullptr; p = p->pNext)
+      freeInSlab[SlabIndex(sorted, p)]++;
+
+    // Rebuild the free list without the blocks of released slabs, keeping
+    // the original order of the survivors.
+    TFreeBlock* pHead = nullptr;
+    TFreeBlock** pTail = &pHead;
+    size_t kept = 0;
+    for (TFreeBlock* p = pFree; p != nullptr; p = p->pNext)
+      if (freeInSlab[SlabIndex(sorted, p)] != perSlab)
+      {
+        *pTail = p;
+        pTail = &p->pNext;
+        kept++;
+      }
+    *pTail = nullptr;
+    pFree = pHead;
+    freeCount = kept;
+
+    size_t released = 0;
+    slabs.clear();
+    for (size_t i = 0; i < sorted.size(); i++)
+      if (freeInSlab[i] == perSlab)
+      {
+        FreeSlab(sorted[i]);
+        released++;
+      }
+      else
+        slabs.push_back(sorted[i]);
+    return released;
+  }
+
+private:
+  struct TFreeBlock
+  {
+    TFreeBlock* pNext;
+  };
+
+  size_t perSlab;
+  size_t objSize;
+  size_t objAlign;
+  size_t blockSize;
+  std::vector<char*> slabs;
+  TFreeBlock* pFree;
+  size_t freeCount;
+  size_t liveCount;
+  size_t highWater;
+
+  void AddSlab()
+  {
+    char* slab = static_cast<char*>(::operator new(perSlab * blockSize, std::align_val_t(objAlign)));
+    try
+    {
+      slabs.push_back(slab);
+    }
+    catch (...)
+    {
+      ::operator delete(slab, std::align_val_t(objAlign));
+      throw;
+    }
+    // Thread in address order so consecutive allocations are adjacent.
+    for (size_t i = perSlab; i > 0; i--)
+    {
+      TFreeBlock* b = reinterpret_cast<TFreeBlock*>(slab + (i - 1) * blockSize);
+      b->pNext = pFree;
+      pFree = b;
+    }
+    freeCount += perSlab;
+  }
+
+  void FreeSlab(char* slab) noexcept
+  {
+    ::operator delete(slab, std::align_val_t(objAlign));
+  }
+
+  size_t SlabIndex(const std::vector<char*>& sorted, const void* p) const
+  {
+    const char* c = static_cast<const char*>(p);
+    auto it = std::upper_bound(sorted.begin(), sorted.end(), c, std::less<const char*>());
+    return static_cast<size_t>(it - sorted.begin()) - 1;
+  }
+};
+
+// Allocator drawing single objects from a shared TNodePool. Copies (including
+// rebound ones) share the pool; a default-constructed allocator owns a fresh
+// one. Array requests and objects that do not fit the pool's block size go
+// to the heap.
+template <class T>
+class TPoolAllocator
+{
+public:
+  using value_type = T;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  TPoolAllocator() : pPool(std::make_shared<TNodePool>()) {}
+  explicit TPoolAllocator(size_t nodesPerSlab) : pPool(std::make_shared<TNodePool>(nodesPerSlab)) {}
+  explicit TPoolAllocator(std::shared_ptr<TNodePool> pool) : pPool(std::move(pool)) {}
+
+  // No move operations: a moved-from list must keep a usable pool.
+  TPoolAllocator(const TPoolAllocator&) = default;
+  TPoolAllocator& operator=(const TPoolAllocator&) = default;
+
+  template <class U>
+  TPoolAllocator(const TPoolAllocator<U>& other) noexcept : pPool(other.pPool) {}
+
+  T* allocate(size_t n)
+  {
+    if (n == 1 && pPool->Accepts(sizeof(T), alignof(T)))
+      return static_cast<T*>(pPool->Allocate());
+    if (n > std::numeric_limits<size_t>::max() / sizeof(T))
+      throw std::bad_array_new_length();
+    return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+  }
+
+  void deallocate(T* p, size_t n) noexcept
+  {
+    if (n == 1 && pPool->Accepts(sizeof(T), alignof(T)))
+      pPool->Deallocate(p);
+    else
+      ::operator delete(p, std::align_val_t(alignof(T)));
+  }
+
+  TNodePool& pool() const noexcept { return *pPool; }
+
+  template <class U>
+  bool operator==(const TPoolAllocator<U>& other) const noexcept { return pPool == other.pPool; }
+  template <class U>
+  bool operator!=(const TPoolAllocator<U>& other) const noexcept { return pPool != other.pPool; }
+
+private:
+  std::shared_ptr<TNodePool> pPool;
+
+  template <class> friend class TPoolAllocator;
+};
+
+// TList in pool mode: nodes are recycled through the pool's free list.
+// Statistics and shrink_to_fit() are reached via get_allocator().pool().
+template <class T>
+using TPooledList = TList<T, TPoolAllocator<T>>;
+
+namespace pmr
+{
+  // TList drawing its nodes from a std::pmr::memory_resource. Backing it with
+  // a monotonic_buffer_resource makes node deallocation a no-op, so a whole
+  // request's lists are released together with the arena.
+  template <class T>
+  using TList = ::TList<T, std::pmr::polymorphic_allocator<T>>;
+}
+
+// Storage for N nodes of type Node inside the object that owns it. Slots
+// are handed out first in order and then from a free list threaded through
+// returned slots, so both directions are O(1) and never touch the heap.
+template <class Node, size_t N>
+class TInlineNodeStore
+{
+public:
+  TInlineNodeStore() noexcept = default;
+  TInlineNodeStore(const TInlineNodeStore&) = delete;
+  TInlineNodeStore& operator=(const TInlineNodeStore&) = delete;
+
+  // A free slot, or nullptr when all N are in use.
+  void* Take() noexcept
+  {
+    if (pFree != nullptr)
+    {
+      TSlot* p = pFree;
+      pFree = p->pNext;
+      return p;
+    }
+    return fresh < N ? &slots[fresh++] : nullptr;
+  }
+
+  void Give(void* p) noexcept
+  {
+    TSlot* s = static_cast<TSlot*>(p);
+    s->pNext = pFree;
+    pFree = s;
+  }
+
+  bool Owns(const void* p) const noexcept
+  {
+    // Compared as integers: relational operators on unrelated pointers are
+    // unspecified.
+    auto a = reinterpret_cast<uintptr_t>(p);
+    return a >= reinterpret_cast<uintptr_t>(slots) && a < reinterpret_cast<uintptr_t>(slots + N);
+  }
+
+private:
+  union TSlot
+  {
+    TSlot* pNext;
+    alignas(Node) unsigned char bytes[sizeof(Node)];
+  };
+
+  TSlot slots[N];
+  TSlot* pFree = nullptr;
+  size_t fresh = 0;
+};
+
+// Allocator serving single Node-sized requests from a TInlineNodeStore and
+// everything else, including nodes past the first N, from Upstream. Never
+// propagates: the store belongs to one container object.
+template <class T, class Node, size_t N, class Upstream = std::allocator<T>>
+class TInlineAllocator
+{
+  using TUpstream = typename std::allocator_traits<Upstream>::template rebind_alloc<T>;
+  using TUpstreamTraits = std::allocator_traits<TUpstream>;
+
+public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::false_type;
+  using propagate_on_container_move_assignment = std::false_type;
+  using propagate_on_container_swap = std::false_type;
+  using is_always_equal = std::false_type;
+
+  template <class U>
+  struct rebind
+  {
+    using other = TInlineAllocator<U, Node, N, Upstream>;
+  };
+
+  TInlineAllocator(TInlineNodeStore<Node, N>* store, const Upstream& up = Upstream()) noexcept
+    : pStore(store), upstream(up)
+  {
+  }
+
+  template <class U>
+  TInlineAllocator(const TInlineAllocator<U, Node, N, Upstream>& other) noexcept
+    : pStore(other.pStore), upstream(other.upstream)
+  {
+  }
+
+  T* allocate(size_t n)
+  {
+    if (n == 1 && Inline())
+      if (void* p = pStore->Take())
+        return static_cast<T*>(p);
+    return std::addressof(*TUpstreamTraits::allocate(upstream, n));
+  }
+
+  void deallocate(T* p, size_t n) noexcept
+  {
+    if (n == 1 && Inline() && pStore->Owns(p))
+      pStore->Give(p);
+    else
+      TUpstreamTraits::deallocate(upstream, p, n);
+  }
+
+  // The allocator that requests past the inline store go to.
+  Upstream upstream_allocator() const noexcept { return Upstream(upstream); }
+
+  template <class U>
+  bool operator==(const TInlineAllocator<U, Node, N, Upstream>& other) const noexcept
+  {
+    return pStore == other.pStore && upstream == other.upstream;
+  }
+  template <class U>
+  bool operator!=(const TInlineAllocator<U, Node, N, Upstream>& other) const noexcept
+  {
+    return !(*this == other);
+  }
+
+private:
+  TInlineNodeStore<Node, N>* pStore;
+  TUpstream upstream;
+
+  static constexpr bool Inline() noexcept { return sizeof(T) == sizeof(Node) && alignof(T) <= alignof(Node); }
+
+  template <class, class, size_t, class> friend class TInlineAllocator;
+};
+
+// TList whose first N nodes live inside the list object itself, so a list
+// that never holds more than N elements never allocates; longer lists
+// spill to Alloc. All of TList is available. Nodes cannot change owner:
+// moving or swapping two TSmallLists moves their elements one by one, and
+// splicing between two of them throws std::invalid_argument like splicing
+// between lists with unequal allocators; split_at moves the cut-off
+// elements into a new TSmallList. The allocator returned by get_allocator()
+// refers to this list's storage and must not outlive it.
+template <class T, size_t N = 8, class Alloc = std::allocator<T>>
+class TSmallList : private TInlineNodeStore<TListNode<T>, N>,
+                   public TList<T, TInlineAllocator<T, TListNode<T>, N, Alloc>>
+{
+  using TStore = TInlineNodeStore<TListNode<T>, N>;
+  using TBase = TList<T, TInlineAllocator<T, TListNode<T>, N, Alloc>>;
+
+public:
+  using typename TBase::allocator_type;
+  using typename TBase::size_type;
+
+  static constexpr size_t inline_capacity = N;
+
+  explicit TSmallList(const Alloc& alloc = Alloc()) : TBase(allocator_type(Store(), alloc)) {}
+
+  TSmallList(size_type n, const T& value, const Alloc& alloc = Alloc()) : TBase(n, value, allocator_type(Store(), alloc))
+  {
+  }
+
+  template <class InputIt, class = std::enable_if_t<!std::is_integral<InputIt>::value>>
+  TSmallList(InputIt first, InputIt last, const Alloc& alloc = Alloc())
+    : TBase(first, last, allocator_type(Store(), alloc))
+  {
+  }
+
+  TSmallList(std::initializer_list<T> init, const Alloc& alloc = Alloc())
+    : TBase(init, allocator_type(Store(), alloc))
+  {
+  }
+
+  TSmallList(const TSmallList& other)
+    : TBase(other, allocator_type(Store(), std::allocator_traits<Alloc>::select_on_container_copy_construction(
+                                               other.get_allocator().upstream_allocator())))
+  {
+  }
+
+  TSmallList(TSmallList&& other)
+    : TBase(std::move(other), allocator_type(Store(), other.get_allocator().upstream_allocator()))
+  {
+  }
+
+  TSmallList& operator=(const TSmallList& other)
+  {
+    TBase::operator=(other);
+    return *this;
+  }
+
+  TSmallList& operator=(TSmallList&& other)
+  {
+    TBase::operator=(std::move(other));
+    return *this;
+  }
+
+  TSmallList& operator=(std::initializer_list<T> init)
+  {
+    TBase::operator=(init);
+    return *this;
+  }
+
+  void swap(TSmallList& other)
+  {
+    if (this == &other)
+      return;
+    TSmallList tmp(std::move(other));
+    other = std::move(*this);
+    *this = std::move(tmp);
+  }
+
+  // Like TList::split_at, except that nodes cannot leave this list's
+  // storage: the elements of [pos, end) are moved one by one into the
+  // returned list, which has the same upstream allocator. Linear in the
+  // length of the tail.
+  TSmallList split_at(typename TBase::const_iterator pos)
+  {
+    TSmallList tail(this->get_allocator().upstream_allocator());
+    auto first = TBase::erase(pos, pos);
+    for (auto it = first; it != TBase::end(); ++it)
+      tail.push_back(std::move(*it));
+    TBase::erase(first, TBase::end());
+    return tail;
+  }
+
+private:
+  TStore* Store() noexcept { return this; }
+};
+
+template <class T, size_t N, class Alloc>
+void swap(TSmallList<T, N, Alloc>& a, TSmallList<T, N, Alloc>& b)
+{
+  a.swap(b);
+}
+
+// Link part of a TMpscList node: the TList node shape with an atomic next
+// link and no back link.
+struct TMpscNodeBase
+{
+  std::atomic<TMpscNodeBase*> pNext;
+};
+
+template <class T>
+struct TMpscNode : TMpscNodeBase
+{
+  union
+  {
+    T value;
+  };
+
+  TMpscNode() {}
+  ~TMpscNode() {}
+};
+
+// Multi-producer single-consumer FIFO queue (D. Vyukov's intrusive MPSC
+// design). push() may be called from any number of threads and costs one
+// atomic exchange; try_pop() and empty() must only be called by the single
+// consumer thread and use no read-modify-write at all in the common case. A
+// stub node embedded in the queue keeps it non-empty, so neither side ever
+// has to handle a null head or tail.
+//
+// The queue is not linearizable: while a producer is between its exchange
+// and its link store, the consumer cannot see that element or any pushed
+// after it, and try_pop() returns false until the link lands. Alloc must
+// be safe to use from several threads at once.
+template <class T, class Alloc = std::allocator<T>>
+class TMpscList
+{
+  using TNode = TMpscNode<T>;
+  using TNodeAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<TNode>;
+  using TNodeTraits = std::allocator_traits<TNodeAlloc>;
+
+public:
+  using value_type = T;
+  using allocator_type = Alloc;
+
+  TMpscList() : TMpscList(Alloc()) {}
+
+  explicit TMpscList(const Alloc& alloc) : nodeAlloc(alloc), pHead(&stub), pTail(&stub)
+  {
+    stub.pNext.store(nullptr, std::memory_order_relaxed);
+  }
+
+  TMpscList(const TMpscList&) = delete;
+  TMpscList& operator=(const TMpscList&) = delete;
+
+  // Must not race with producers.
+  ~TMpscList()
+  {
+    if (pPending != nullptr)
+      DestroyNode(pPending);
+    while (TNode* n = PopNode())
+      DestroyNode(n);
+  }
+
+  void push(const T& value) { emplace(value); }
+  void push(T&& value) { emplace(std::move(value)); }
+
+  template <class... Args>
+  void emplace(Args&&... args)
+  {
+    TNode* n = std::addressof(*TNodeTraits::allocate(nodeAlloc, 1));
+    TNodeTraits::construct(nodeAlloc, n);
+    try
+    {
+      TNodeTraits::construct(nodeAlloc, std::addressof(n->value), std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+      TNodeTraits::destroy(nodeAlloc, n);
+      TNodeTraits::deallocate(nodeAlloc, n, 1);
+      throw;
+    }
+    PushNode(n);
+  }
+
+  // Consumer only. Moves the oldest visible element into out. If that
+  // throws, the element stays at the front of the queue for the next
+  // try_pop. A T whose move assignment may throw is copied instead when it
+  // can be, so the element is then also left unchanged.
+  bool try_pop(T& out)
+  {
+    TNode* n = pPending != nullptr ? pPending : PopNode();
+    if (n == nullptr)
+      return false;
+    pPending = n;
+    if constexpr (std::is_nothrow_move_assignable<T>::value || !std::is_copy_assignable<T>::value)
+      out = std::move(n->value);
+    else
+      out = n->value;
+    pPending = nullptr;
+    DestroyNode(n);
+    return true;
+  }
+
+  // Consumer only. True if no element is visible to the consumer.
+  bool empty() const noexcept
+  {
+    if (pPending != nullptr)
+      return false;
+    const TMpscNodeBase* t = pTail;
+    if (t == &stub)
+      t = stub.pNext.load(std::memory_order_acquire);
+    return t == nullptr;
+  }
+
+private:
+  TNodeAlloc nodeAlloc;
+  // Producers and the consumer work on opposite ends; keep them on separate
+  // cache lines.
+  alignas(64) std::atomic<TMpscNodeBase*> pHead;
+  alignas(64) TMpscNodeBase* pTail;
+  TMpscNodeBase stub;
+  // Consumer only: a node already unlinked whose element try_pop failed to
+  // hand out.
+  TNode* pPending = nullptr;
+
+  void PushNode(TMpscNodeBase* n) noexcept
+  {
+    n->pNext.store(nullptr, std::memory_order_relaxed);
+    TMpscNodeBase* prev = pHead.exchange(n, std::memory_order_acq_rel);
+    prev->pNext.store(n, std::memory_order_release);
+  }
+
+  TNode* PopNode() noexcept
+  {
+    TMpscNodeBase* t = pTail;
+    TMpscNodeBase* next = t->pNext.load(std::memory_order_acquire);
+    if (t == &stub)
+    {
+      if (next == nullptr)
+        return nullptr;
+      pTail = next;
+      t = next;
+      next = next->pNext.load(std::memory_order_acquire);
+    }
+    if (next != nullptr)
+    {
+      pTail = next;
+      return static_cast<TNode*>(t);
+    }
+    // t is the last node we can see. Unless a producer is mid-push, park the
+    // stub behind it so t can be handed out without emptying the chain.
+    if (t != pHead.load(std::memory_order_acquire))
+      return nullptr;
+    PushNode(&stub);
+    next = t->pNext.load(std::memory_order_acquire);
+    if (next != nullptr)
+    {
+      pTail = next;
+      return static_cast<TNode*>(t);
+    }
+    return nullptr;
+  }
+
+  void DestroyNode(TNode* n) noexcept
+  {
+    TNodeTraits::destroy(nodeAlloc, std::addressof(n->value));
+    TNodeTraits::destroy(nodeAlloc, n);
+    TNodeTraits::deallocate(nodeAlloc, n, 1);
+  }
+};
+
+// Epoch-based memory reclamation. A thread pins the domain for the duration
+// of every access to shared nodes; a node that has been unlinked is retired
+// instead of freed and only released once every thread that could still
+// hold a pointer to it has unpinned. Pinning is a store, a fence and a load
+// with no read-modify-write (after a thread's first pin, which claims its
+// record); retire() is a push onto a thread-local bag, and
+// every few dozen retires the thread tries to advance the global epoch and
+// frees what has become unreachable.
+//
+// Each thread gets a record in every domain it touches; records are reused
+// after the thread exits. The domain must outlive all pins, and the
+// destructor frees everything still retired, so it must not race with any
+// other use.
+class TEpochDomain
+{
+  struct TRetired
+  {
+    void* p;
+    void (*release)(void* ctx, void* p);
+    void* ctx;
+  };
+
+  struct TBag
+  {
+    uint64_t epoch = 0;
+    std::vector<TRetired> items;
+  };
+
+  struct TRecord
+  {
+    // (epoch << 1) | pinned
+    std::atomic<uint64_t> state{ 0 };
+    std::atomic<bool> inUse{ false };
+    TRecord* pNext = nullptr;
+    // Only touched by the owning thread.
+    unsigned nesting = 0;
+    unsigned retiresSinceScan = 0;
+    TBag bags[3];
+  };
+
+  // Shared with the thread-local record caches, so a thread that exits after
+  // the domain died can still hand its record back safely.
+  struct TState
+  {
+    std::atomic<uint64_t> epoch{ 2 };
+    std::atomic<TRecord*> pRecords{ nullptr };
+    std::atomic<bool> alive{ true };
+
+    ~TState()
+    {
+      for (TRecord* r = pRecords.load(); r != nullptr;)
+      {
+        TRecord* next = r->pNext;
+        delete r;
+        r = next;
+      }
+    }
+  };
+
+  struct TLocalRecords
+  {
+    struct TEntry
+    {
+      std::shared_ptr<TState> state;
+      TRecord* rec;
+    };
+
+    std::vector<TEntry> entries;
+
+    ~TLocalRecords()
+    {
+      for (TEntry& e : entries)
+        e.rec->inUse.store(false, std::memory_order_release);
+    }
+  };
+
+  static const unsigned ScanEvery = 64;
+
+public:
+  // RAII pin. Pins nest; only the outermost one announces the thread.
+  class TGuard
+  {
+  public:
+    explicit TGuard(TEpochDomain& d) : pRec(d.Pin()) {}
+    TGuard(const TGuard&) = delete;
+    TGuard& operator=(const TGuard&) = delete;
+
+    ~TGuard()
+    {
+      if (--pRec->nesting == 0)
+        pRec->state.store(0, std::memory_order_release);
+    }
+
+  private:
+    TRecord* pRec;
+  };
+
+  TEpochDomain() : pState(std::make_shared<TState>()) {}
+  TEpochDomain(const TEpochDomain&) = delete;
+  TEpochDomain& operator=(const TEpochDomain&) = delete;
+
+  ~TEpochDomain()
+  {
+    pState->alive.store(false, std::memory_order_release);
+    for (TRecord* r = pState->pRecords.load(std::memory_order_acquire); r != nullptr; r = r->pNext)
+      for (TBag& b : r->bags)
+        FreeBag(b);
+  }
+
+  TGuard pin() { return TGuard(*this); }
+
+  // Hands p to release(ctx, p) once no pinned thread can reach it. p must
+  // already be unreachable for threads that pin from now on.
+  void retire(void* p, void (*release)(void*, void*), void* ctx)
+  {
+    TRecord* r = Local();
+    uint64_t tag = pState->epoch.load(std::memory_order_seq_cst);
+    TBag& bag = r->bags[tag % 3];
+    if (bag.epoch != tag)
+    {
+      // The bag was filled at least three epochs ago, so it is safe.
+      FreeBag(bag);
+      bag.epoch = tag;
+    }
+    bag.items.push_back(TRetired{ p, release, ctx });
+    if (++r->retiresSinceScan >= ScanEvery)
+    {
+      r->retiresSinceScan = 0;
+      TryAdvance();
+      Collect(r);
+    }
+  }
+
+  // Advances the epoch as far as the pinned threads allow and frees this
+  // thread's nodes that became safe. Mostly useful in tests and at quiet
+  // points; retire() does the same periodically.
+  void collect()
+  {
+    TRecord* r = Local();
+    TryAdvance();
+    TryAdvance();
+    Collect(r);
+  }
+
+  // Waits for a grace period: returns once every node this thread retired
+  // has been freed. Must not be called while this thread is pinned.
+  void synchronize()
+  {
+    TRecord* r = Local();
+    while (true)
+    {
+      TryAdvance();
+      Collect(r);
+      if (r->bags[0].items.empty() && r->bags[1].items.empty() && r->bags[2].items.empty())
+        return;
+      std::this_thread::yield();
+    }
+  }
+
+private:
+  std::shared_ptr<TState> pState;
+
+  static TLocalRecords& LocalRecords()
+  {
+    thread_local TLocalRecords records;
+    return records;
+  }
+
+  TRecord* Local()
+  {
+    TLocalRecords& local = LocalRecords();
+    for (auto& e : local.entries)
+      if (e.state == pState)
+        return e.rec;
+
+    // Hand back records of domains that no longer exist.
+    for (size_t i = 0; i < local.entries.size();)
+      if (!local.entries[i].state->alive.load(std::memory_order_acquire))
+      {
+        local.entries[i].rec->inUse.store(false, std::memory_order_release);
+        local.entries.erase(local.entries.begin() + i);
+      }
+      else
+        i++;
+
+    TRecord* rec = Acquire();
+    local.entries.push_back({ pState, rec });
+    return rec;
+  }
+
+  TRecord* Acquire()
+  {
+    for (TRecord* r = pState->pRecords.load(std::memory_order_acquire); r != nullptr; r = r->pNext)
+    {
+      bool expected = false;
+      if (!r->inUse.load(std::memory_order_relaxed) &&
+          r->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+        return r;
+    }
+    TRecord* r = new TRecord;
+    r->inUse.store(true, std::memory_order_relaxed);
+    TRecord* head = pState->pRecords.load(std::memory_order_relaxed);
+    do
+      r->pNext = head;
+    while (!pState->pRecords.compare_exchange_weak(head, r, std::memory_order_release, std::memory_order_relaxed));
+    return r;
+  }
+
+  TRecord* Pin()
+  {
+    TRecord* r = Local();
+    if (r->nesting++ == 0)
+    {
+      // Announce an epoch that is still current after the announcement is
+      // visible, otherwise an advance could slip in between.
+      // A plain store and a fence rather than a seq_cst store, which some
+      // targets implement as an exchange: pinning is a read-side path.
+      // ThreadSanitizer does not model fences, so it gets the seq_cst store.
+      uint64_t e = pState->epoch.load(std::memory_order_seq_cst);
+      while (true)
+      {
+#if TLIST_TSAN
+        r->state.store((e << 1) | 1, std::memory_order_seq_cst);
+#else
+        r->state.store((e << 1) | 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+#endif
+        uint64_t now = pState->epoch.load(std::memory_order_seq_cst);
+        if (now == e)
+          break;
+        e = now;
+      }
+    }
+    return r;
+  }
+
+  // The epoch moves on only when every pinned thread has seen the current
+  // one.
+  void TryAdvance()
+  {
+    // Pairs with the fence in Pin(): either the reader's announcement is
+    // seen here or the reader sees the unlink that preceded this scan.
+#if !TLIST_TSAN
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+#endif
+    uint64_t e = pState->epoch.load(std::memory_order_seq_cst);
+    for (TRecord* r = pState->pRecords.load(std::memory_order_acquire); r != nullptr; r = r->pNext)
+    {
+      uint64_t s = r->state.load(std::memory_order_seq_cst);
+      if ((s & 1) && (s >> 1) != e)
+        return;
+    }
+    pState->epoch.compare_exchange_strong(e, e + 1, std::memory_order_seq_cst);
+  }
+
+  // Nodes retired in epoch e are unreachable once the epoch reaches e + 2.
+  void Collect(TRecord* r)
+  {
+    uint64_t e = pState->epoch.load(std::memory_order_seq_cst);
+    for (TBag& b : r->bags)
+      if (b.epoch + 2 <= e)
+        FreeBag(b);
+  }
+
+  static void FreeBag(TBag& b)
+  {
+    for (TRetired& item : b.items)
+      item.release(item.ctx, item.p);
+    b.items.clear();
+  }
+};
+
+// Node of TConcurrentSortedList. The low bit of next marks the node itself
+// as logically deleted.
+template <class T>
+struct TConcurrentNode
+{
+  std::atomic<uintptr_t> next;
+  union
+  {
+    T value;
+  };
+
+  TConcurrentNode() {}
+  ~TConcurrentNode() {}
+};
+
+// Lock-free sorted set (Harris' list with Michael's refinements). insert,
+// erase and contains may be called from any number of threads. erase first
+// marks the node's next link, which makes it logically absent and freezes
+// its successor, then unlinks it; any traversal that meets a marked node
+// helps to unlink it. Unlinked nodes are reclaimed through a TEpochDomain,
+// so readers never touch freed memory. contains() never writes shared
+// memory apart from its own epoch record.
+template <class T, class Compare = std::less<T>, class Alloc = std::allocator<T>>
+class TConcurrentSortedList
+{
+  using TNode = TConcurrentNode<T>;
+  using TNodeAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<TNode>;
+  using TNodeTraits = std::allocator_traits<TNodeAlloc>;
+
+  static constexpr uintptr_t Mark = 1;
+
+public:
+  using value_type = T;
+  using allocator_type = Alloc;
+
+  TConcurrentSortedList() : TConcurrentSortedList(Compare(), Alloc()) {}
+
+  explicit TConcurrentSortedList(const Compare& comp, const Alloc& alloc = Alloc()) : less(comp), nodeAlloc(alloc)
+  {
+    head.store(0, std::memory_order_relaxed);
+  }
+
+  TConcurrentSortedList(const TConcurrentSortedList&) = delete;
+  TConcurrentSortedList& operator=(const TConcurrentSortedList&) = delete;
+
+  // Must not race with any other member call.
+  ~TConcurrentSortedList()
+  {
+    uintptr_t p = head.load(std::memory_order_acquire);
+    while (Ptr(p) != nullptr)
+    {
+      TNode* n = Ptr(p);
+      p = n->next.load(std::memory_order_relaxed);
+      DestroyNode(n);
+    }
+  }
+
+  // Returns false if an equal element is already present.
+  bool insert(const T& value)
+  {
+    TNode* n = CreateNode(value);
+    TEpochDomain::TGuard guard(domain);
+    while (true)
+    {
+      std::atomic<uintptr_t>* prev;
+      TNode* curr;
+      Find(value, prev, curr);
+      if (curr != nullptr && !less(value, curr->value))
+      {
+        DestroyNode(n);
+        return false;
+      }
+      n->next.store(reinterpret_cast<uintptr_t>(curr), std::memory_order_relaxed);
+      uintptr_t expected = reinterpret_cast<uintptr_t>(curr);
+      if (prev->compare_exchange_strong(expected, reinterpret_cast<uintptr_t>(n), std::memory_order_release,
+                                        std::memory_order_relaxed))
+        return true;
+    }
+  }
+
+  // Returns false if no equal element was present.
+  bool erase(const T& value)
+  {
+    TEpochDomain::TGuard guard(domain);
+    while (true)
+    {
+      std::atomic<uintptr_t>* prev;
+      TNode* curr;
+      Find(value, prev, curr);
+      if (curr == nullptr || less(value, curr->value))
+        return false;
+      uintptr_t next = curr->next.load(std::memory_order_acquire);
+      if (next & Mark)
+        continue;
+      if (!curr->next.compare_exchange_strong(next, next | Mark, std::memory_order_acq_rel,
+                                              std::memory_order_relaxed))
+        continue;
+      // Logically erased; unlink it here or let the next Find do it.
+      uintptr_t expected = reinterpret_cast<uintptr_t>(curr);
+      if (prev->compare_exchange_strong(expected, next, std::memory_order_acq_rel, std::memory_order_relaxed))
+        Retire(curr);
+      else
+        Find(value, prev, curr);
+      return true;
+    }
+  }
+
+  bool contains(const T& value)
+  {
+    TEpochDomain::TGuard guard(domain);
+    TNode* curr = Ptr(head.load(std::memory_order_acquire));
+    while (curr != nullptr && less(curr->value, value))
+      curr = Ptr(curr->next.load(std::memory_order_acquire));
+    return curr != nullptr && !less(value, curr->value) && !(curr->next.load(std::memory_order_acquire) & Mark);
+  }
+
+  // Calls f on every element that is present when it is visited, in order.
+  // Concurrent inserts and erases may or may not be seen.
+  template <class F>
+  void for_each(F f)
+  {
+    TEpochDomain::TGuard guard(domain);
+    for (TNode* curr = Ptr(head.load(std::memory_order_acquire)); curr != nullptr;)
+    {
+      uintptr_t next = curr->next.load(std::memory_order_acquire);
+      if (!(next & Mark))
+        f(static_cast<const T&>(curr->value));
+      curr = Ptr(next);
+    }
+  }
+
+  // Frees retired nodes that have become safe; see TEpochDomain::collect.
+  void collect() { domain.collect(); }
+
+private:
+  std::atomic<uintptr_t> head;
+  Compare less;
+  TNodeAlloc nodeAlloc;
+  // Declared last so it is destroyed first, while nodeAlloc can still free
+  // the nodes it holds.
+  TEpochDomain domain;
+
+  static TNode* Ptr(uintptr_t p) { return reinterpret_cast<TNode*>(p & ~Mark); }
+
+  // Positions prev/curr so that curr is the first node not less than value
+  // and *prev pointed to it, unlinking every marked node on the way.
+  void Find(const T& value, std::atomic<uintptr_t>*& prev, TNode*& curr)
+  {
+  retry:
+    prev = &head;
+    curr = Ptr(prev->load(std::memory_order_acquire));
+    while (curr != nullptr)
+    {
+      uintptr_t next = curr->next.load(std::memory_order_acquire);
+      if (prev->load(std::memory_order_acquire) != reinterpret_cast<uintptr_t>(curr))
+        goto retry;
+      if (next & Mark)
+      {
+        uintptr_t expected = reinterpret_cast<uintptr_t>(curr);
+        if (!prev->compare_exchange_strong(expected, next & ~Mark, std::memory_order_acq_rel,
+                                           std::memory_order_relaxed))
+          goto retry;
+        Retire(curr);
+        curr = Ptr(next);
+        continue;
+      }
+      if (!less(curr->value, value))
+        return;
+      prev = &curr->next;
+      curr = Ptr(next);
+    }
+  }
+
+  TNode* CreateNode(const T& value)
+  {
+    TNode* n = std::addressof(*TNodeTraits::allocate(nodeAlloc, 1));
+    TNodeTraits::construct(nodeAlloc, n);
+    try
+    {
+      TNodeTraits::construct(nodeAlloc, std::addressof(n->value), value);
+    }
+    catch (...)
+    {
+      TNodeTraits::destroy(nodeAlloc, n);
+      TNodeTraits::deallocate(nodeAlloc, n, 1);
+      throw;
+    }
+    return n;
+  }
+
+  void DestroyNode(TNode* n) noexcept
+  {
+    TNodeTraits::destroy(nodeAlloc, std::addressof(n->value));
+    TNodeTraits::destroy(nodeAlloc, n);
+    TNodeTraits::deallocate(nodeAlloc, n, 1);
+  }
+
+  void Retire(TNode* n)
+  {
+    domain.retire(n, [](void* ctx, void* p) {
+      static_cast<TConcurrentSortedList*>(ctx)->DestroyNode(static_cast<TNode*>(p));
+    }, this);
+  }
+};
+
+// Test-and-test-and-set spinlock, one byte of state. Yields after a short
+// spin so oversubscribed threads still make progress.
+class TSpinLock
+{
+public:
+  void lock() noexcept
+  {
+    while (true)
+    {
+      if (!locked.exchange(true, std::memory_order_acquire))
+        return;
+      for (int spins = 0; locked.load(std::memory_order_relaxed); spins++)
+        if (spins >= 64)
+          std::this_thread::yield();
+    }
+  }
+
+  bool try_lock() noexcept
+  {
+    return !locked.load(std::memory_order_relaxed) && !locked.exchange(true, std::memory_order_acquire);
+  }
+
+  void unlock() noexcept { locked.store(false, std::memory_order_release); }
+
+private:
+  std::atomic<bool> locked{ false };
+};
+
+struct TLockCoupledNodeBase
+{
+  TSpinLock lock;
+  TLockCoupledNodeBase* pNext = nullptr;
+};
+
+template <class T>
+struct TLockCoupledNode : TLockCoupledNodeBase
+{
+  union
+  {
+    T value;
+  };
+
+  TLockCoupledNode() {}
+  ~TLockCoupledNode() {}
+};
+
+// Sorted set guarded by one spinlock per node. Every traversal holds the
+// lock of the node it stands on and takes the next one before letting go
+// (hand-over-hand), so a thread is never overtaken and writers only block
+// each other while their windows overlap. A node is unlinked while holding
+// both its own and its predecessor's lock; nobody else can then reach it,
+// so it is freed immediately.
+template <class T, class Compare = std::less<T>, class Alloc = std::allocator<T>>
+class TLockCoupledList
+{
+  using TNode = TLockCoupledNode<T>;
+  using TNodeAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<TNode>;
+  using TNodeTraits = std::allocator_traits<TNodeAlloc>;
+
+public:
+  using value_type = T;
+  using allocator_type = Alloc;
+
+  TLockCoupledList() : TLockCoupledList(Compare(), Alloc()) {}
+
+  explicit TLockCoupledList(const Compare& comp, const Alloc& alloc = Alloc()) : less(comp), nodeAlloc(alloc) {}
+
+  TLockCoupledList(const TLockCoupledList&) = delete;
+  TLockCoupledList& operator=(const TLockCoupledList&) = delete;
+
+  // Must not race with any other member call.
+  ~TLockCoupledList()
+  {
+    TLockCoupledNodeBase* p = head.pNext;
+    while (p != nullptr)
+    {
+      TLockCoupledNodeBase* next = p->pNext;
+      DestroyNode(static_cast<TNode*>(p));
+      p = next;
+    }
+  }
+
+  // Returns false if an equal element is already present.
+  bool insert(const T& value)
+  {
+    TNode* n = CreateNode(value);
+    TLockCoupledNodeBase* prev;
+    TNode* curr;
+    Find(value, prev, curr);
+    bool found = curr != nullptr && !less(value, curr->value);
+    if (!found)
+    {
+      n->pNext = curr;
+      prev->pNext = n;
+    }
+    if (curr != nullptr)
+      curr->lock.unlock();
+    prev->lock.unlock();
+    if (found)
+      DestroyNode(n);
+    return !found;
+  }
+
+  // Returns false if no equal element was present.
+  bool erase(const T& value)
+  {
+    TLockCoupledNodeBase* prev;
+    TNode* curr;
+    Find(value, prev, curr);
+    if (curr == nullptr || less(value, curr->value))
+    {
+      if (curr != nullptr)
+        curr->lock.unlock();
+      prev->lock.unlock();
+      return false;
+    }
+    prev->pNext = curr->pNext;
+    curr->lock.unlock();
+    prev->lock.unlock();
+    DestroyNode(curr);
+    return true;
+  }
+
+  bool contains(const T& value)
+  {
+    TLockCoupledNodeBase* prev;
+    TNode* curr;
+    Find(value, prev, curr);
+    bool found = curr != nullptr && !less(value, curr->value);
+    if (curr != nullptr)
+      curr->lock.unlock();
+    prev->lock.unlock();
+    return found;
+  }
+
+  // Calls f on every element in order, holding the element's lock.
+  template <class F>
+  void for_each(F f)
+  {
+    TLockCoupledNodeBase* prev = &head;
+    prev->lock.lock();
+    while (prev->pNext != nullptr)
+    {
+      TLockCoupledNodeBase* curr = prev->pNext;
+      curr->lock.lock();
+      prev->lock.unlock();
+      f(static_cast<const T&>(static_cast<TNode*>(curr)->value));
+      prev = curr;
+    }
+    prev->lock.unlock();
+  }
+
+private:
+  TLockCoupledNodeBase head;
+  Compare less;
+  TNodeAlloc nodeAlloc;
+
+  // Returns with prev and curr (if any) locked, curr being the first node
+  // not less than value and prev its predecessor.
+  void Find(const T& value, TLockCoupledNodeBase*& prev, TNode*& curr)
+  {
+    prev = &head;
+    prev->lock.lock();
+    curr = static_cast<TNode*>(prev->pNext);
+    if (curr != nullptr)
+      curr->lock.lock();
+    while (curr != nullptr && less(curr->value, value))
+    {
+      prev->lock.unlock();
+      prev = curr;
+      curr = static_cast<TNode*>(curr->pNext);
+      if (curr != nullptr)
+        curr->lock.lock();
+    }
+  }
+
+  TNode* CreateNode(const T& value)
+  {
+    TNode* n = std::addressof(*TNodeTraits::allocate(nodeAlloc, 1));
+    TNodeTraits::construct(nodeAlloc, n);
+    try
+    {
+      TNodeTraits::construct(nodeAlloc, std::addressof(n->value), value);
+    }
+    catch (...)
+    {
+      TNodeTraits::destroy(nodeAlloc, n);
+      TNodeTraits::deallocate(nodeAlloc, n, 1);
+      throw;
+    }
+    return n;
+  }
+
+  void DestroyNode(TNode* n) noexcept
+  {
+    TNodeTraits::destroy(nodeAlloc, std::addressof(n->value));
+    TNodeTraits::destroy(nodeAlloc, n);
+    TNodeTraits::deallocate(nodeAlloc, n, 1);
+  }
+};
+
+template <class T>
+struct TRcuNode
+{
+  std::atomic<TRcuNode*> pNext;
+  union
+  {
+    T value;
+  };
+
+  TRcuNode() {}
+  ~TRcuNode() {}
+};
+
+template <class T>
+class TRcuIterator
+{
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = T;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const T*;
+  using reference = const T&;
+
+  TRcuIterator() : pNode(nullptr) {}
+  explicit TRcuIterator(const TRcuNode<T>* p) : pNode(p) {}
+
+  reference operator*() const { return pNode->value; }
+  pointer operator->() const { return std::addressof(pNode->value); }
+
+  TRcuIterator& operator++()
+  {
+    pNode = pNode->pNext.load(std::memory_order_acquire);
+    return *this;
+  }
+
+  TRcuIterator operator++(int)
+  {
+    TRcuIterator old = *this;
+    ++*this;
+    return old;
+  }
+
+  bool operator==(const TRcuIterator& other) const { return pNode == other.pNode; }
+  bool operator!=(const TRcuIterator& other) const { return pNode != other.pNode; }
+
+private:
+  const TRcuNode<T>* pNode;
+};
+
+// Read-mostly singly linked list in the RCU style, for data that is read
+// far more often than it changes. Readers take read_lock() and walk the
+// list with acquire loads only: no locks, no read-modify-write, and they
+// never wait for a writer. Writers are serialized by a mutex, never modify
+// a node a reader may be standing on (replace_if publishes a copy), link
+// new nodes with release stores and retire unlinked ones to a TEpochDomain,
+// which frees them after a grace period. Writers free what is already safe
+// as they go; synchronize() waits for the rest.
+template <class T, class Alloc = std::allocator<T>>
+class TRcuList
+{
+  using TNode = TRcuNode<T>;
+  using TNodeAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<TNode>;
+  using TNodeTraits = std::allocator_traits<TNodeAlloc>;
+
+public:
+  using value_type = T;
+  using allocator_type = Alloc;
+  using size_type = size_t;
+  using const_iterator = TRcuIterator<T>;
+  using read_guard = TEpochDomain::TGuard;
+
+  TRcuList() : TRcuList(Alloc()) {}
+
+  explicit TRcuList(const Alloc& alloc) : nodeAlloc(alloc)
+  {
+    head.store(nullptr, std::memory_order_relaxed);
+  }
+
+  TRcuList(std::initializer_list<T> init, const Alloc& alloc = Alloc()) : TRcuList(alloc)
+  {
+    for (const T& v : init)
+      push_back(v);
+  }
+
+  TRcuList(const TRcuList&) = delete;
+  TRcuList& operator=(const TRcuList&) = delete;
+
+  // Must not race with any other member call.
+  ~TRcuList()
+  {
+    TNode* p = head.load(std::memory_order_relaxed);
+    while (p != nullptr)
+    {
+      TNode* next = p->pNext.load(std::memory_order_relaxed);
+      DestroyNode(p);
+      p = next;
+    }
+  }
+
+  // Readers. Iterators are only valid while the calling thread holds a
+  // read_lock(); read locks nest.
+  read_guard read_lock() const { return read_guard(domain); }
+
+  const_iterator begin() const { return const_iterator(head.load(std::memory_order_acquire)); }
+  const_iterator end() const { return const_iterator(); }
+
+  template <class F>
+  void for_each(F f) const
+  {
+    read_guard guard(domain);
+    for (const T& v : *this)
+      f(v);
+  }
+
+  // Copies the first element matching pred into out.
+  template <class Pred>
+  bool find_if(Pred pred, T& out) const
+  {
+    read_guard guard(domain);
+    for (const T& v : *this)
+      if (pred(v))
+      {
+        out = v;
+        return true;
+      }
+    return false;
+  }
+
+  size_type size() const { return count.load(std::memory_order_relaxed); }
+  bool empty() const { return size() == 0; }
+
+  // Writers.
+  void push_front(const T& value)
+  {
+    TNode* n = CreateNode(value);
+    std::lock_guard<std::mutex> lock(writer);
+    TNode* first = head.load(std::memory_order_relaxed);
+    n->pNext.store(first, std::memory_order_relaxed);
+    head.store(n, std::memory_order_release);
+    if (first == nullptr)
+      pTail = n;
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  void push_back(const T& value)
+  {
+    TNode* n = CreateNode(value);
+    n->pNext.store(nullptr, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(writer);
+    (pTail != nullptr ? pTail->pNext : head).store(n, std::memory_order_release);
+    pTail = n;
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  // Unlinks every element matching pred; returns how many.
+  template <class Pred>
+  size_type remove_if(Pred pred)
+  {
+    std::lock_guard<std::mutex> lock(writer);
+    size_type removed = 0;
+    std::atomic<TNode*>* link = &head;
+    TNode* prev = nullptr;
+    for (TNode* curr = link->load(std::memory_order_relaxed); curr != nullptr;)
+    {
+      TNode* next = curr->pNext.load(std::memory_order_relaxed);
+      if (pred(static_cast<const T&>(curr->value)))
+      {
+        link->store(next, std::memory_order_release);
+        if (curr == pTail)
+          pTail = prev;
+        Retire(curr);
+        removed++;
+      }
+      else
+      {
+        prev = curr;
+        link = &curr->pNext;
+      }
+      curr = next;
+    }
+    Commit(removed);
+    return removed;
+  }
+
+  // Replaces every element matching pred with a copy of value, so readers
+  // see either the old or the new element, never a half-written one.
+  template <class Pred>
+  size_type replace_if(Pred pred, const T& value)
+  {
+    std::lock_guard<std::mutex> lock(writer);
+    size_type replaced = 0;
+    std::atomic<TNode*>* link = &head;
+    for (TNode* curr = link->load(std::memory_order_relaxed); curr != nullptr;)
+    {
+      TNode* next = curr->pNext.load(std::memory_order_relaxed);
+      if (pred(static_cast<const T&>(curr->value)))
+      {
+        TNode* n = CreateNode(value);
+        n->pNext.store(next, std::memory_order_relaxed);
+        link->store(n, std::memory_order_release);
+        if (curr == pTail)
+          pTail = n;
+        Retire(curr);
+        replaced++;
+        curr = n;
+      }
+      link = &curr->pNext;
+      curr = next;
+    }
+    Commit(0);
+    return replaced;
+  }
+
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(writer);
+    TNode* p = head.load(std::memory_order_relaxed);
+    head.store(nullptr, std::memory_order_release);
+    pTail = nullptr;
+    size_type removed = 0;
+    while (p != nullptr)
+    {
+      TNode* next = p->pNext.load(std::memory_order_relaxed);
+      Retire(p);
+      removed++;
+      p = next;
+    }
+    Commit(removed);
+  }
+
+  // Waits until every node this thread has unlinked is freed. Must not be
+  // called while holding a read lock.
+  void synchronize() { domain.synchronize(); }
+
+private:
+  std::atomic<TNode*> head;
+  TNode* pTail = nullptr;
+  std::atomic<size_type> count{ 0 };
+  std::mutex writer;
+  TNodeAlloc nodeAlloc;
+  // Declared last so it is destroyed first, while nodeAlloc can still free
+  // the nodes it holds.
+  mutable TEpochDomain domain;
+
+  // Called by writers with the mutex held.
+  void Commit(size_type removed)
+  {
+    count.store(count.load(std::memory_order_relaxed) - removed, std::memory_order_relaxed);
+    domain.collect();
+  }
+
+  TNode* CreateNode(const T& value)
+  {
+    TNode* n = std::addressof(*TNodeTraits::allocate(nodeAlloc, 1));
+    TNodeTraits::construct(nodeAlloc, n);
+    try
+    {
+      TNodeTraits::construct(nodeAlloc, std::addressof(n->value), value);
+    }
+    catch (...)
+    {
+      TNodeTraits::destroy(nodeAlloc, n);
+      TNodeTraits::deallocate(nodeAlloc, n, 1);
+      throw;
+    }
+    return n;
+  }
+
+  void DestroyNode(TNode* n) noexcept
+  {
+    TNodeTraits::destroy(nodeAlloc, std::addressof(n->value));
+    TNodeTraits::destroy(nodeAlloc, n);
+    TNodeTraits::deallocate(nodeAlloc, n, 1);
+  }
+
+  void Retire(TNode* n)
+  {
+    domain.retire(n, [](void* ctx, void* p) {
+      static_cast<TRcuList*>(ctx)->DestroyNode(static_cast<TNode*>(p));
+    }, this);
+  }
+};
+
+// Open-addressing hash table of list iterators, the side index behind
+// TIndexedList and TLruCache. Each slot holds an iterator and the full hash
+// of its key, so probing compares hashes before keys and growing never
+// rehashes a key. Linear probing over a power-of-two array kept at most
+// three quarters full; Fibonacci hashing spreads weak hashes such as the
+// identity std::hash<int>. Erase shifts the rest of the probe run back, so
+// there are no tombstones. A default-constructed Iterator marks an empty
+// slot. KeyOf maps an iterator to its element's key.
+template <class Iterator, class Key, class KeyOf, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>,
+          class Alloc = std::allocator<Key>>
+class THashIndex
+{
+  struct TSlot
+  {
+    Iterator it;
+    size_t hash;
+  };
+
+  using TSlotAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<TSlot>;
+  using TSlotTraits = std::allocator_traits<TSlotAlloc>;
+
+public:
+  explicit THashIndex(const Hash& h = Hash(), const KeyEqual& eq = KeyEqual(), const Alloc& alloc = Alloc())
+    : hasher(h), equal(eq), slotAlloc(alloc)
+  {
+  }
+
+  THashIndex(const THashIndex&) = delete;
+  THashIndex& operator=(const THashIndex&) = delete;
+
+  THashIndex(THashIndex&& other) noexcept
+    : hasher(std::move(other.hasher)), equal(std::move(other.equal)), slotAlloc(other.slotAlloc),
+      pSlots(other.pSlots), mask(other.mask), used(other.used)
+  {
+    other.pSlots = nullptr;
+    other.mask = 0;
+    other.used = 0;
+  }
+
+  ~THashIndex() { FreeSlots(); }
+
+  void swap(THashIndex& other) noexcept
+  {
+    using std::swap;
+    swap(hasher, other.hasher);
+    swap(equal, other.equal);
+    if constexpr (TSlotTraits::propagate_on_container_swap::value)
+      swap(slotAlloc, other.slotAlloc);
+    swap(pSlots, other.pSlots);
+    swap(mask, other.mask);
+    swap(used, other.used);
+  }
+
+  size_t size() const noexcept { return used; }
+  size_t capacity() const noexcept { return pSlots == nullptr ? 0 : mask + 1; }
+
+  size_t hash_of(const Key& key) const { return hasher(key); }
+  const Hash& hash_function() const noexcept { return hasher; }
+  const KeyEqual& key_eq() const noexcept { return equal; }
+
+  // Iterator of the element with this key, or Iterator() if there is none.
+  // hash must be hash_of(key).
+  Iterator find(const Key& key, size_t hash) const
+  {
+    if (used == 0)
+      return Iterator();
+    KeyOf keyOf;
+    for (size_t i = Home(hash);; i = (i + 1) & mask)
+    {
+      const TSlot& s = pSlots[i];
+      if (s.it == Iterator())
+        return Iterator();
+      if (s.hash == hash && equal(keyOf(s.it), key))
+        return s.it;
+    }
+  }
+
+  // Adds it under hash, which must be the hash of its key; the key must not
+  // be present yet. May grow the table; if that throws, nothing changes.
+  void insert(Iterator it, size_t hash)
+  {
+    if ((used + 1) * 4 > capacity() * 3)
+      Grow(capacity() == 0 ? 16 : capacity() * 2);
+    Place(it, hash);
+    used++;
+  }
+
+  // Removes it, which must be present under hash.
+  void erase(Iterator it, size_t hash) noexcept
+  {
+    size_t i = Home(hash);
+    while (pSlots[i].it != it)
+      i = (i + 1) & mask;
+    // Shift later members of the probe run back into the hole unless that
+    // would move them in front of their home slot.
+    for (size_t j = (i + 1) & mask; pSlots[j].it != Iterator(); j = (j + 1) & mask)
+    {
+      size_t home = Home(pSlots[j].hash);
+      if (((j - home) & mask) >= ((j - i) & mask))
+      {
+        pSlots[i] = pSlots[j];
+        i = j;
+      }
+    }
+    pSlots[i].it = Iterator();
+    used--;
+  }
+
+  // Makes room for n keys without growing.
+  void reserve(size_t n)
+  {
+    size_t cap = 16;
+    while (n * 4 > cap * 3)
+      cap *= 2;
+    if (cap > capacity())
+      Grow(cap);
+  }
+
+  void clear() noexcept
+  {
+    for (size_t i = 0; i < capacity(); i++)
+      pSlots[i].it = Iterator();
+    used = 0;
+  }
+
+private:
+  Hash hasher;
+  KeyEqual equal;
+  TSlotAlloc slotAlloc;
+  TSlot* pSlots = nullptr;
+  size_t mask = 0;
+  size_t used = 0;
+
+  size_t Home(size_t hash) const noexcept
+  {
+    // The top bits of the golden-ratio product are the well mixed ones.
+    return size_t((uint64_t(hash) * 0x9e3779b97f4a7c15ull) >> 32) & mask;
+  }
+
+  void Place(Iterator it, size_t hash) noexcept
+  {
+    size_t i = Home(hash);
+    while (pSlots[i].it != Iterator())
+      i = (i + 1) & mask;
+    pSlots[i] = TSlot{ it, hash };
+  }
+
+  void Grow(size_t cap)
+  {
+    TSlot* fresh = std::addressof(*TSlotTraits::allocate(slotAlloc, cap));
+    for (size_t i = 0; i < cap; i++)
+      TSlotTraits::construct(slotAlloc, fresh + i, TSlot{ Iterator(), 0 });
+    TSlot* old = pSlots;
+    size_t oldCap = capacity();
+    pSlots = fresh;
+    mask = cap - 1;
+    for (size_t i = 0; i < oldCap; i++)
+      if (old[i].it != Iterator())
+        Place(old[i].it, old[i].hash);
+    if (old != nullptr)
+    {
+      for (size_t i = 0; i < oldCap; i++)
+        TSlotTraits::destroy(slotAlloc, old + i);
+      TSlotTraits::deallocate(slotAlloc, old, oldCap);
+    }
+  }
+
+  void FreeSlots() noexcept
+  {
+    if (pSlots == nullptr)
+      return;
+    for (size_t i = 0; i <= mask; i++)
+      TSlotTraits::destroy(slotAlloc, pSlots + i);
+    TSlotTraits::deallocate(slotAlloc, pSlots, mask + 1);
+    pSlots = nullptr;
+    mask = 0;
+    used = 0;
+  }
+};
+
+// Insertion-ordered set: a TList of unique elements plus a THashIndex from
+// element to node, so find, contains and erase by value are O(1) on
+// average while iteration follows insertion order (a linked hash set).
+// Elements are only reachable through const iterators, since changing one
+// in place would desynchronize the index.
+template <class T, class Hash = std::hash<T>, class KeyEqual = std::equal_to<T>, class Alloc = std::allocator<T>>
+class TIndexedList
+{
+  using TListType = TList<T, Alloc>;
+
+  struct TKeyOf
+  {
+    const T& operator()(typename TListType::const_iterator it) const { return *it; }
+  };
+
+  using TIndex = THashIndex<typename TListType::const_iterator, T, TKeyOf, Hash, KeyEqual, Alloc>;
+
+public:
+  using value_type = T;
+  using allocator_type = Alloc;
+  using size_type = std::size_t;
+  using iterator = typename TListType::const_iterator;
+  using const_iterator = typename TListType::const_iterator;
+  using reverse_iterator = std::reverse_iterator<const_iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  TIndexedList() : TIndexedList(Alloc()) {}
+
+  explicit TIndexedList(const Alloc& alloc, const Hash& hash = Hash(), const KeyEqual& eq = KeyEqual())
+    : items(alloc), index(hash, eq, alloc)
+  {
+  }
+
+  // Duplicates after the first occurrence are dropped.
+  TIndexedList(std::initializer_list<T> init, const Alloc& alloc = Alloc()) : TIndexedList(alloc)
+  {
+    for (const T& v : init)
+      push_back(v);
+  }
+
+  TIndexedList(const TIndexedList& other)
+    : items(other.items), index(other.index.hash_function(), other.index.key_eq(), other.items.get_allocator())
+  {
+    Reindex();
+  }
+
+  TIndexedList(TIndexedList&& other) noexcept = default;
+
+  TIndexedList& operator=(const TIndexedList& other)
+  {
+    if (this != &other)
+    {
+      TIndexedList tmp(other);
+      swap(tmp);
+    }
+    return *this;
+  }
+
+  TIndexedList& operator=(TIndexedList&& other) noexcept
+  {
+    if (this != &other)
+    {
+      TIndexedList tmp(std::move(other));
+      swap(tmp);
+    }
+    return *this;
+  }
+
+  allocator_type get_allocator() const { return items.get_allocator(); }
+  Hash hash_function() const { return index.hash_function(); }
+  KeyEqual key_eq() const { return index.key_eq(); }
+
+  const_iterator begin() const noexcept { return items.begin(); }
+  const_iterator end() const noexcept { return items.end(); }
+  const_iterator cbegin() const noexcept { return items.begin(); }
+  const_iterator cend() const noexcept { return items.end(); }
+  const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+  const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+  bool empty() const noexcept { return items.empty(); }
+  size_type size() const noexcept { return items.size(); }
+
+  const T& front() const { return items.front(); }
+  const T& back() const { return items.back(); }
+
+  const_iterator find(const T& value) const
+  {
+    const_iterator it = index.find(value, index.hash_of(value));
+    return it == const_iterator() ? end() : it;
+  }
+
+  bool contains(const T& value) const { return index.find(value, index.hash_of(value)) != const_iterator(); }
+
+  // Each insert returns the element's position and whether it was added;
+  // an element that is already present stays where it is.
+  std::pair<iterator, bool> push_back(const T& value) { return Insert(end(), value); }
+  std::pair<iterator, bool> push_back(T&& value) { return Insert(end(), std::move(value)); }
+  std::pair<iterator, bool> push_front(const T& value) { return Insert(begin(), value); }
+  std::pair<iterator, bool> push_front(T&& value) { return Insert(begin(), std::move(value)); }
+  std::pair<iterator, bool> insert(const_iterator pos, const T& value) { return Insert(pos, value); }
+  std::pair<iterator, bool> insert(const_iterator pos, T&& value) { return Insert(pos, std::move(value)); }
+
+  iterator erase(const_iterator pos)
+  {
+    index.erase(pos, index.hash_of(*pos));
+    return items.erase(pos);
+  }
+
+  // Returns the number of elements removed (0 or 1).
+  size_type erase(const T& value)
+  {
+    size_t h = index.hash_of(value);
+    const_iterator it = index.find(value, h);
+    if (it == const_iterator())
+      return 0;
+    index.erase(it, h);
+    items.erase(it);
+    return 1;
+  }
+
+  void pop_front() { erase(begin()); }
+  void pop_back() { erase(std::prev(end())); }
+
+  void clear() noexcept
+  {
+    index.clear();
+    items.clear();
+  }
+
+  void reserve(size_type n) { index.reserve(n); }
+
+  void swap(TIndexedList& other) noexcept
+  {
+    items.swap(other.items);
+    index.swap(other.index);
+  }
+
+  friend bool operator==(const TIndexedList& a, const TIndexedList& b) { return a.items == b.items; }
+  friend bool operator!=(const TIndexedList& a, const TIndexedList& b) { return !(a == b); }
+
+private:
+  TListType items;
+  TIndex index;
+
+  template <class V>
+  std::pair<iterator, bool> Insert(const_iterator pos, V&& value)
+  {
+    size_t h = index.hash_of(value);
+    const_iterator found = index.find(value, h);
+    if (found != const_iterator())
+      return { found, false };
+    const_iterator it = items.insert(pos, std::forward<V>(value));
+    try
+    {
+      index.insert(it, h);
+    }
+    catch (...)
+    {
+      items.erase(it);
+      throw;
+    }
+    return { it, true };
+  }
+
+  void Reindex()
+  {
+    index.reserve(items.size());
+    for (const_iterator it = items.begin(); it != items.end(); ++it)
+      index.insert(it, index.hash_of(*it));
+  }
+};
+
+template <class T, class Hash, class KeyEqual, class Alloc>
+void swap(TIndexedList<T, Hash, KeyEqual, Alloc>& a, TIndexedList<T, Hash, KeyEqual, Alloc>& b) noexcept
+{
+  a.swap(b);
+}
+
+// Link fields embedded in a user object for TIntrusiveList. An object can
+// sit in as many intrusive lists at once as it has hooks. Copying an object
+// does not copy its links: the copy starts out unlinked. A hook must be
+// unlinked before its object is destroyed.
+struct TListHook : private TListNodeBase
+{
+  TListHook() noexcept { pNext = pPrev = nullptr; }
+  TListHook(const TListHook&) noexcept : TListHook() {}
+  TListHook& operator=(const TListHook&) noexcept { return *this; }
+
+  bool is_linked() const noexcept { return pNext != nullptr; }
+
+private:
+  template <class U, TListHook U::*> friend struct TIntrusiveLinks;
+};
+
+template <class T, TListHook T::*Hook>
+class TIntrusiveList;
+
+// Converts between an object and the TListNodeBase inside its Hook member.
+template <class T, TListHook T::*Hook>
+struct TIntrusiveLinks
+{
+  static TListNodeBase* NodeOf(const T& obj) noexcept
+  {
+    return const_cast<TListHook*>(&(obj.*Hook));
+  }
+
+  static T* ObjectOf(TListNodeBase* p) noexcept
+  {
+    return reinterpret_cast<T*>(reinterpret_cast<char*>(static_cast<TListHook*>(p)) - Offset());
+  }
+
+  // Byte offset of the hook inside T, read off the representation of Hook
+  // so that no T has to exist: a pointer to data member is that offset as
+  // a ptrdiff_t under the Itanium C++ ABI (GCC, Clang) and starts with it as
+  // an int32_t under the Microsoft ABI. At -O0 this is a copy of a
+  // constant; optimized builds fold it away.
+  static std::ptrdiff_t Offset() noexcept
+  {
+    static constexpr TListHook T::*hook = Hook;
+#if defined(_MSC_VER)
+    using TOffset = int32_t;
+#else
+    using TOffset = std::ptrdiff_t;
+#endif
+    static_assert(sizeof(hook) >= sizeof(TOffset), "TIntrusiveLinks: unexpected member pointer layout");
+    TOffset offset;
+    std::memcpy(&offset, &hook, sizeof(offset));
+    return offset;
+  }
+};
+
+template <class T, TListHook T::*Hook, bool IsConst>
+class TIntrusiveIterator
+{
+  using TLinks = TIntrusiveLinks<T, Hook>;
+
+public:
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = T;
+  using difference_type = std::ptrdiff_t;
+  using pointer = std::conditional_t<IsConst, const T*, T*>;
+  using reference = std::conditional_t<IsConst, const T&, T&>;
+
+  TIntrusiveIterator() : pNode(nullptr) {}
+  explicit TIntrusiveIterator(const TListNodeBase* p) : pNode(const_cast<TListNodeBase*>(p)) {}
+
+  template <bool C = IsConst, class = std::enable_if_t<C>>
+  TIntrusiveIterator(const TIntrusiveIterator<T, Hook, false>& it) : pNode(it.pNode) {}
+
+  reference operator*() const { return *TLinks::ObjectOf(pNode); }
+  pointer operator->() const { return TLinks::ObjectOf(pNode); }
+
+  TIntrusiveIterator& operator++()
+  {
+    pNode = pNode->pNext;
+    return *this;
+  }
+
+  TIntrusiveIterator operator++(int)
+  {
+    TIntrusiveIterator tmp = *this;
+    pNode = pNode->pNext;
+    return tmp;
+  }
+
+  TIntrusiveIterator& operator--()
+  {
+    pNode = pNode->pPrev;
+    return *this;
+  }
+
+  TIntrusiveIterator operator--(int)
+  {
+    TIntrusiveIterator tmp = *this;
+    pNode = pNode->pPrev;
+    return tmp;
+  }
+
+  friend bool operator==(const TIntrusiveIterator& a, const TIntrusiveIterator& b) { return a.pNode == b.pNode; }
+  friend bool operator!=(const TIntrusiveIterator& a, const TIntrusiveIterator& b) { return a.pNode != b.pNode; }
+
+private:
+  TListNodeBase* pNode;
+
+  template <class U, TListHook U::*, bool> friend class TIntrusiveIterator;
+  friend class TIntrusiveList<T, Hook>;
+};
+
+// Doubly linked list of objects it does not own. The links live in the
+// object's Hook member, so linking and unlinking never allocate and an
+// object is unlinked in O(1) from a reference alone. The list never copies
+// or destroys its elements; when it is cleared or destroyed the elements
+// are just unlinked.
+template <class T, TListHook T::*Hook>
+class TIntrusiveList
+{
+  using TLinks = TIntrusiveLinks<T, Hook>;
+
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using iterator = TIntrusiveIterator<T, Hook, false>;
+  using const_iterator = TIntrusiveIterator<T, Hook, true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  TIntrusiveList() noexcept { Reset(); }
+
+  TIntrusiveList(const TIntrusiveList&) = delete;
+  TIntrusiveList& operator=(const TIntrusiveList&) = delete;
+
+  TIntrusiveList(TIntrusiveList&& other) noexcept
+  {
+    Reset();
+    splice(end(), other);
+  }
+
+  TIntrusiveList& operator=(TIntrusiveList&& other) noexcept
+  {
+    if (this != &other)
+    {
+      clear();
+      splice(end(), other);
+    }
+    return *this;
+  }
+
+  ~TIntrusiveList() { clear(); }
+
+  iterator begin() noexcept { return iterator(sentinel.pNext); }
+  const_iterator begin() const noexcept { return const_iterator(sentinel.pNext); }
+  iterator end() noexcept { return iterator(&sentinel); }
+  const_iterator end() const noexcept { return const_iterator(&sentinel); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+  bool empty() const noexcept { return count == 0; }
+  size_type size() const noexcept { return count; }
+
+  T& front()
+  {
+    CheckNotEmpty();
+    return *begin();
+  }
+
+  const T& front() const
+  {
+    CheckNotEmpty();
+    return *begin();
+  }
+
+  T& back()
+  {
+    CheckNotEmpty();
+    return *std::prev(end());
+  }
+
+  const T& back() const
+  {
+    CheckNotEmpty();
+    return *std::prev(end());
+  }
+
+  // Iterator to obj, which must be in this list. O(1).
+  iterator iterator_to(T& obj) noexcept { return iterator(TLinks::NodeOf(obj)); }
+  const_iterator iterator_to(const T& obj) const noexcept { return const_iterator(TLinks::NodeOf(obj)); }
+
+  // Links obj in front of pos. Throws std::invalid_argument if obj's hook is
+  // already in a list.
+  iterator insert(const_iterator pos, T& obj)
+  {
+    TListNodeBase* p = TLinks::NodeOf(obj);
+    if (p->pNext != nullptr)
+      throw std::invalid_argument("TIntrusiveList: object is already linked");
+    p->pNext = pos.pNode;
+    p->pPrev = pos.pNode->pPrev;
+    pos.pNode->pPrev->pNext = p;
+    pos.pNode->pPrev = p;
+    count++;
+    return iterator(p);
+  }
+
+  void push_front(T& obj) { insert(begin(), obj); }
+  void push_back(T& obj) { insert(end(), obj); }
+
+  void pop_front()
+  {
+    CheckNotEmpty();
+    erase(begin());
+  }
+
+  void pop_back()
+  {
+    CheckNotEmpty();
+    erase(std::prev(end()));
+  }
+
+  // Unlinks the element at pos and returns the one after it.
+  iterator erase(const_iterator pos) noexcept
+  {
+    TListNodeBase* next = pos.pNode->pNext;
+    Unlink(pos.pNode);
+    count--;
+    return iterator(next);
+  }
+
+  // Unlinks obj, which must be in this list. O(1).
+  void erase(T& obj) noexcept { erase(iterator_to(obj)); }
+
+  // Unlinks every element for which pred holds; returns how many.
+  template <class Pred>
+  size_type remove_if(Pred pred)
+  {
+    size_type removed = 0;
+    for (iterator it = begin(); it != end();)
+      if (pred(*it))
+      {
+        it = erase(it);
+        removed++;
+      }
+      else
+        ++it;
+    return removed;
+  }
+
+  void clear() noexcept
+  {
+    for (TListNodeBase* p = sentinel.pNext; p != &sentinel;)
+    {
+      TListNodeBase* next = p->pNext;
+      p->pNext = p->pPrev = nullptr;
+      p = next;
+    }
+    Reset();
+  }
+
+  // Moves every element of other in front of pos. O(1).
+  void splice(const_iterator pos, TIntrusiveList& other) noexcept
+  {
+    if (this == &other || other.count == 0)
+      return;
+    TListNodeBase* first = other.sentinel.pNext;
+    TListNodeBase* last = other.sentinel.pPrev;
+    first->pPrev = pos.pNode->pPrev;
+    last->pNext = pos.pNode;
+    pos.pNode->pPrev->pNext = first;
+    pos.pNode->pPrev = last;
+    count += other.count;
+    other.Reset();
+  }
+
+  // Moves obj, which must be in other, in front of pos. O(1); this is how
+  // an object migrates between lists sharing the same hook.
+  void splice(const_iterator pos, TIntrusiveList& other, T& obj) noexcept
+  {
+    TListNodeBase* p = TLinks::NodeOf(obj);
+    if (pos.pNode == p)
+      return;
+    Unlink(p);
+    other.count--;
+    p->pNext = pos.pNode;
+    p->pPrev = pos.pNode->pPrev;
+    pos.pNode->pPrev->pNext = p;
+    pos.pNode->pPrev = p;
+    count++;
+  }
+
+  void swap(TIntrusiveList& other) noexcept
+  {
+    TIntrusiveList tmp(std::move(other));
+    other.splice(other.end(), *this);
+    splice(end(), tmp);
+  }
+
+private:
+  TListNodeBase sentinel;
+  size_type count;
+
+  void Reset() noexcept
+  {
+    sentinel.pNext = sentinel.pPrev = &sentinel;
+    count = 0;
+  }
+
+  static void Unlink(TListNodeBase* p) noexcept
+  {
+    p->pPrev->pNext = p->pNext;
+    p->pNext->pPrev = p->pPrev;
+    p->pNext = p->pPrev = nullptr;
+  }
+
+  void CheckNotEmpty() const
+  {
+    if (count == 0)
+      throw std::out_of_range("TIntrusiveList: list is empty");
+  }
+};
+
+template <class T, TListHook T::*Hook>
+void swap(TIntrusiveList<T, Hook>& a, TIntrusiveList<T, Hook>& b) noexcept
+{
+  a.swap(b);
+}
+
+// Link part of a TXorList node: the addresses of both neighbours XORed
+// into one word.
+struct TXorNodeBase
+{
+  uintptr_t link;
+};
+
+template <class T>
+struct TXorNode : TXorNodeBase
+{
+  union
+  {
+    T value;
+  };
+
+  TXorNode() {}
+  ~TXorNode() {}
+};
+
+template <class T, class Alloc = std::allocator<T>>
+class TXorList;
+
+// A node alone cannot say which way is forward, so a TXorList iterator
+// carries the node before it as well.
+template <class T, bool IsConst>
+class TXorIterator
+{
+public:
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = T;
+  using difference_type = std::ptrdiff_t;
+  using pointer = std::conditional_t<IsConst, const T*, T*>;
+  using reference = std::conditional_t<IsConst, const T&, T&>;
+
+  TXorIterator() : pPrev(nullptr), pNode(nullptr) {}
+
+  template <bool C = IsConst, class = std::enable_if_t<C>>
+  TXorIterator(const TXorIterator<T, false>& it) : pPrev(it.pPrev), pNode(it.pNode) {}
+
+  reference operator*() const { return static_cast<TXorNode<T>*>(pNode)->value; }
+  pointer operator->() const { return std::addressof(**this); }
+
+  TXorIterator& operator++()
+  {
+    TXorNodeBase* next = Other(pNode, pPrev);
+    pPrev = pNode;
+    pNode = next;
+    return *this;
+  }
+
+  TXorIterator operator++(int)
+  {
+    TXorIterator tmp = *this;
+    ++*this;
+    return tmp;
+  }
+
+  TXorIterator& operator--()
+  {
+    TXorNodeBase* before = Other(pPrev, pNode);
+    pNode = pPrev;
+    pPrev = before;
+    return *this;
+  }
+
+  TXorIterator operator--(int)
+  {
+    TXorIterator tmp = *this;
+    --*this;
+    return tmp;
+  }
+
+  friend bool operator==(const TXorIterator& a, const TXorIterator& b) { return a.pNode == b.pNode; }
+  friend bool operator!=(const TXorIterator& a, const TXorIterator& b) { return a.pNode != b.pNode; }
+
+private:
+  TXorNodeBase* pPrev;
+  TXorNodeBase* pNode;
+
+  TXorIterator(const TXorNodeBase* prev, const TXorNodeBase* p)
+    : pPrev(const_cast<TXorNodeBase*>(prev)), pNode(const_cast<TXorNodeBase*>(p))
+  {
+  }
+
+  // Neighbour of p on the side away from known.
+  static TXorNodeBase* Other(const TXorNodeBase* p, const TXorNodeBase* known) noexcept
+  {
+    return reinterpret_cast<TXorNodeBase*>(p->link ^ reinterpret_cast<uintptr_t>(known));
+  }
+
+  template <class, bool> friend class TXorIterator;
+  template <class, class> friend class TXorList;
+};
+
+// Doubly linked list whose nodes keep a single link word, prev XOR next, so
+// it walks both ways at the memory cost of a singly linked list. Like TList
+// it is a ring through an embedded sentinel; the list also remembers the
+// first node, since the sentinel's link only gives first XOR last. Because
+// iterators carry their predecessor, an insert in front of an element or
+// an erase of the element before it invalidates iterators to that element.
+// Use the iterator returned by insert or erase to continue. reverse() is
+// O(1).
+template <class T, class Alloc>
+class TXorList
+{
+  using TNode = TXorNode<T>;
+  using TNodeAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<TNode>;
+  using TNodeTraits = std::allocator_traits<TNodeAlloc>;
+
+public:
+  using value_type = T;
+  using allocator_type = Alloc;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using iterator = TXorIterator<T, false>;
+  using const_iterator = TXorIterator<T, true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  TXorList() : TXorList(Alloc()) {}
+
+  explicit TXorList(const Alloc& alloc) noexcept : nodeAlloc(alloc)
+  {
+    Reset();
+  }
+
+  template <class InputIt, class = std::enable_if_t<!std::is_integral<InputIt>::value>>
+  TXorList(InputIt first, InputIt last, const Alloc& alloc = Alloc()) : TXorList(alloc)
+  {
+    for (; first != last; ++first)
+      emplace_back(*first);
+  }
+
+  TXorList(std::initializer_list<T> init, const Alloc& alloc = Alloc()) : TXorList(init.begin(), init.end(), alloc) {}
+
+  TXorList(const TXorList& other)
+    : TXorList(other.begin(), other.end(), TNodeTraits::select_on_container_copy_construction(other.nodeAlloc))
+  {
+  }
+
+  TXorList(TXorList&& other) noexcept : nodeAlloc(std::move(other.nodeAlloc))
+  {
+    Reset();
+    Steal(other);
+  }
+
+  ~TXorList()
+  {
+    clear();
+  }
+
+  TXorList& operator=(const TXorList& other)
+  {
+    if (this != &other)
+    {
+      constexpr bool propagate = TNodeTraits::propagate_on_container_copy_assignment::value;
+      TXorList tmp(other.begin(), other.end(), propagate ? other.nodeAlloc : nodeAlloc);
+      clear();
+      if constexpr (propagate)
+        nodeAlloc = other.nodeAlloc;
+      Steal(tmp);
+    }
+    return *this;
+  }
+
+  TXorList& operator=(TXorList&& other) noexcept(TNodeTraits::propagate_on_container_move_assignment::value ||
+                                                 TNodeTraits::is_always_equal::value)
+  {
+    if (this == &other)
+      return *this;
+    if constexpr (TNodeTraits::propagate_on_container_move_assignment::value)
+    {
+      clear();
+      nodeAlloc = std::move(other.nodeAlloc);
+      Steal(other);
+    }
+    else if (nodeAlloc == other.nodeAlloc)
+    {
+      clear();
+      Steal(other);
+    }
+    else
+    {
+      // other's nodes belong to its allocator, so the elements move one by one.
+      TXorList tmp(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()), get_allocator());
+      clear();
+      Steal(tmp);
+      other.clear();
+    }
+    return *this;
+  }
+
+  allocator_type get_allocator() const { return allocator_type(nodeAlloc); }
+
+  iterator begin() noexcept { return iterator(&sentinel, pFirst); }
+  const_iterator begin() const noexcept { return const_iterator(&sentinel, pFirst); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  iterator end() noexcept { return iterator(Last(), &sentinel); }
+  const_iterator end() const noexcept { return const_iterator(Last(), &sentinel); }
+  const_iterator cend() const noexcept { return end(); }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+  bool empty() const noexcept { return count == 0; }
+  size_type size() const noexcept { return count; }
+
+  T& front()
+  {
+    CheckNotEmpty();
+    return Value(pFirst);
+  }
+
+  const T& front() const
+  {
+    CheckNotEmpty();
+    return Value(pFirst);
+  }
+
+  T& back()
+  {
+    CheckNotEmpty();
+    return Value(Last());
+  }
+
+  const T& back() const
+  {
+    CheckNotEmpty();
+    return Value(Last());
+  }
+
+  void push_front(const T& value) { emplace_front(value); }
+  void push_front(T&& value) { emplace_front(std::move(value)); }
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  template <class... Args>
+  T& emplace_front(Args&&... args)
+  {
+    return *emplace(begin(), std::forward<Args>(args)...);
+  }
+
+  template <class... Args>
+  T& emplace_back(Args&&... args)
+  {
+    return *emplace(end(), std::forward<Args>(args)...);
+  }
+
+  void pop_front()
+  {
+    CheckNotEmpty();
+    erase(begin());
+  }
+
+  void pop_back()
+  {
+    CheckNotEmpty();
+    erase(std::prev(end()));
+  }
+
+  iterator insert(const_iterator pos, const T& value) { return emplace(pos, value); }
+  iterator insert(const_iterator pos, T&& value) { return emplace(pos, std::move(value)); }
+
+  // Links the new element between pos and the element before it. pos is
+  // invalidated; the returned iterator and its successor are valid.
+  template <class... Args>
+  iterator emplace(const_iterator pos, Args&&... args)
+  {
+    TNode* p = CreateNode(std::forward<Args>(args)...);
+    TXorNodeBase* prev = pos.pPrev;
+    TXorNodeBase* next = pos.pNode;
+    p->link = Addr(prev) ^ Addr(next);
+    prev->link ^= Addr(next) ^ Addr(p);
+    next->link ^= Addr(prev) ^ Addr(p);
+    if (prev == &sentinel)
+      pFirst = p;
+    count++;
+    return iterator(prev, p);
+  }
+
+  // Returns the element after pos, which stays valid; iterators to that
+  // element obtained earlier do not.
+  iterator erase(const_iterator pos)
+  {
+    TXorNodeBase* prev = pos.pPrev;
+    TXorNodeBase* p = pos.pNode;
+    TXorNodeBase* next = reinterpret_cast<TXorNodeBase*>(p->link ^ Addr(prev));
+    prev->link ^= Addr(p) ^ Addr(next);
+    next->link ^= Addr(p) ^ Addr(prev);
+    if (p == pFirst)
+      pFirst = next;
+    count--;
+    DestroyNode(static_cast<TNode*>(p));
+    return iterator(prev, next);
+  }
+
+  iterator erase(const_iterator first, const_iterator last)
+  {
+    // Erasing first invalidates last when they are neighbours, so count
+    // the range and erase by iterator returned.
+    size_type n = 0;
+    for (const_iterator it = first; it != last; ++it)
+      n++;
+    iterator it(first.pPrev, first.pNode);
+    for (; n > 0; n--)
+      it = erase(it);
+    return it;
+  }
+
+  void clear() noexcept
+  {
+    TXorNodeBase* prev = &sentinel;
+    TXorNodeBase* p = pFirst;
+    while (p != &sentinel)
+    {
+      TXorNodeBase* next = reinterpret_cast<TXorNodeBase*>(p->link ^ Addr(prev));
+      prev = p;
+      DestroyNode(static_cast<TNode*>(p));
+      p = next;
+    }
+    Reset();
+  }
+
+  // Reverses the order of the elements in O(1): the ring stays as it is and
+  // only which end counts as the first changes.
+  void reverse() noexcept
+  {
+    pFirst = Last();
+  }
+
+  void swap(TXorList& other) noexcept
+  {
+    using std::swap;
+    if constexpr (TNodeTraits::propagate_on_container_swap::value)
+      swap(nodeAlloc, other.nodeAlloc);
+    TXorList tmp(other.nodeAlloc);
+    tmp.Steal(other);
+    other.Steal(*this);
+    Steal(tmp);
+  }
+
+  friend bool operator==(const TXorList& a, const TXorList& b)
+  {
+    return a.count == b.count && std::equal(a.begin(), a.end(), b.begin());
+  }
+
+  friend bool operator!=(const TXorList& a, const TXorList& b) { return !(a == b); }
+
+  friend std::ostream& operator<<(std::ostream& os, const TXorList& l)
+  {
+    os << '{';
+    for (auto it = l.begin(); it != l.end(); ++it)
+      os << (it == l.begin() ? "" : ", ") << *it;
+    return os << '}';
+  }
+
+private:
+  TXorNodeBase sentinel;
+  TXorNodeBase* pFirst;
+  size_type count;
+  TNodeAlloc nodeAlloc;
+
+  static uintptr_t Addr(const TXorNodeBase* p) noexcept { return reinterpret_cast<uintptr_t>(p); }
+
+  static T& Value(TXorNodeBase* p) { return static_cast<TNode*>(p)->value; }
+  static const T& Value(const TXorNodeBase* p) { return static_cast<const TNode*>(p)->value; }
+
+  TXorNodeBase* Last() const noexcept
+  {
+    return reinterpret_cast<TXorNodeBase*>(sentinel.link ^ Addr(pFirst));
+  }
+
+  void Reset() noexcept
+  {
+    sentinel.link = 0;
+    pFirst = &sentinel;
+    count = 0;
+  }
+
+  // Takes over the ring of other, whose end nodes still link to other's
+  // sentinel, and leaves other empty. Allocators must be equal.
+  void Steal(TXorList& other) noexcept
+  {
+    if (other.count == 0)
+    {
+      Reset();
+      return;
+    }
+    TXorNodeBase* first = other.pFirst;
+    TXorNodeBase* last = other.Last();
+    uintptr_t moved = Addr(&other.sentinel) ^ Addr(&sentinel);
+    // With one element first == last and the two updates cancel out, as
+    // they must: its link is sentinel XOR sentinel = 0 either way.
+    first->link ^= moved;
+    last->link ^= moved;
+    sentinel.link = other.sentinel.link;
+    pFirst = first;
+    count = other.count;
+    other.Reset();
+  }
+
+  template <class... Args>
+  TNode* CreateNode(Args&&... args)
+  {
+    TNode* p = std::addressof(*TNodeTraits::allocate(nodeAlloc, 1));
+    TNodeTraits::construct(nodeAlloc, p);
+    try
+    {
+      TNodeTraits::construct(nodeAlloc, std::addressof(p->value), std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+      TNodeTraits::destroy(nodeAlloc, p);
+      TNodeTraits::deallocate(nodeAlloc, p, 1);
+      throw;
+    }
+    return p;
+  }
+
+  void DestroyNode(TNode* p) noexcept
+  {
+    TNodeTraits::destroy(nodeAlloc, std::addressof(p->value));
+    TNodeTraits::destroy(nodeAlloc, p);
+    TNodeTraits::deallocate(nodeAlloc, p, 1);
+  }
+
+  void CheckNotEmpty() const
+  {
+    if (count == 0)
+      throw std::out_of_range("TXorList: list is empty");
+  }
+};
+
+template <class T, class Alloc>
+void swap(TXorList<T, Alloc>& a, TXorList<T, Alloc>& b) noexcept
+{
+  a.swap(b);
+}
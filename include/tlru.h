@@ -0,0 +1,226 @@
+﻿#pragma once
+#include "tlist.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+// Default weight of a cache entry: the bytes of its key and value objects.
+// Give TLruCache a weigher of its own when keys or values own heap memory
+// (strings, vectors) that the weight limit should account for.
+struct TLruSizeofWeight
+{
+  template <class K, class V>
+  size_t operator()(const K&, const V&) const noexcept
+  {
+    return sizeof(K) + sizeof(V);
+  }
+};
+
+// Least-recently-used cache: a TList of entries ordered from most to least
+// recently used plus a THashIndex from key to node. get, put and erase are
+// O(1) on average; a hit moves its entry to the front by relinking the
+// node, so no entry is ever copied or reallocated after it is stored.
+// Entries are evicted from the back whenever the cache holds more than
+// max_count() entries or more than max_weight() in total weight, as measured
+// by Weigher(key, value). Not thread-safe.
+template <class K, class V, class Hash = std::hash<K>, class KeyEqual = std::equal_to<K>,
+          class Weigher = TLruSizeofWeight, class Alloc = std::allocator<std::pair<const K, V>>>
+class TLruCache
+{
+public:
+  struct TEntry
+  {
+    K key;
+    V value;
+    size_t weight;
+  };
+
+private:
+  using TEntryAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<TEntry>;
+  using TEntries = TList<TEntry, TEntryAlloc>;
+  using TPosition = typename TEntries::iterator;
+
+  struct TKeyOf
+  {
+    const K& operator()(TPosition it) const { return it->key; }
+  };
+
+  using TIndex = THashIndex<TPosition, K, TKeyOf, Hash, KeyEqual, Alloc>;
+
+public:
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = TEntry;
+  using size_type = std::size_t;
+  using const_iterator = typename TEntries::const_iterator;
+  using iterator = const_iterator;
+
+  static constexpr size_t Unlimited = std::numeric_limits<size_t>::max();
+
+  // Throws std::invalid_argument if maxCount is 0.
+  explicit TLruCache(size_t maxCount, size_t maxWeight = Unlimited, const Weigher& w = Weigher(),
+                     const Alloc& alloc = Alloc())
+    : entries(TEntryAlloc(alloc)), index(Hash(), KeyEqual(), alloc), weigher(w)
+  {
+    set_capacity(maxCount, maxWeight);
+  }
+
+  TLruCache(const TLruCache&) = delete;
+  TLruCache& operator=(const TLruCache&) = delete;
+
+  size_type size() const noexcept { return entries.size(); }
+  bool empty() const noexcept { return entries.empty(); }
+  size_t weight() const noexcept { return totalWeight; }
+  size_t max_count() const noexcept { return maxCount; }
+  size_t max_weight() const noexcept { return maxWeight; }
+
+  // Entries from the most to the least recently used.
+  const_iterator begin() const noexcept { return entries.begin(); }
+  const_iterator end() const noexcept { return entries.end(); }
+
+  // Value stored under key, or nullptr. Counts a hit or a miss and makes a
+  // hit the most recently used entry. The pointer stays valid until the
+  // entry is evicted, erased or replaced.
+  V* get(const K& key)
+  {
+    TPosition it = index.find(key, index.hash_of(key));
+    if (it == TPosition())
+    {
+      missCount++;
+      return nullptr;
+    }
+    hitCount++;
+    entries.splice(entries.begin(), entries, it);
+    return &it->value;
+  }
+
+  // Lookup that neither counts nor changes the eviction order.
+  const V* peek(const K& key) const
+  {
+    TPosition it = index.find(key, index.hash_of(key));
+    return it == TPosition() ? nullptr : &it->value;
+  }
+
+  bool contains(const K& key) const { return index.find(key, index.hash_of(key)) != TPosition(); }
+
+  // Stores value under key as the most recently used entry, replacing any
+  // previous value, then evicts down to capacity. An entry heavier than
+  // max_weight() on its own is dropped instead, leaving the rest of the
+  // cache alone, and put returns false.
+  template <class VV>
+  bool put(const K& key, VV&& value)
+  {
+    size_t h = index.hash_of(key);
+    TPosition it = index.find(key, h);
+    if (it != TPosition())
+    {
+      it->value = std::forward<VV>(value);
+      totalWeight -= it->weight;
+      entries.splice(entries.begin(), entries, it);
+    }
+    else
+    {
+      entries.push_front(TEntry{ key, V(std::forward<VV>(value)), 0 });
+      it = entries.begin();
+      try
+      {
+        index.insert(it, h);
+      }
+      catch (...)
+      {
+        entries.pop_front();
+        throw;
+      }
+    }
+    it->weight = weigher(it->key, it->value);
+    totalWeight += it->weight;
+    if (it->weight > maxWeight)
+    {
+      Remove(it, h);
+      return false;
+    }
+    Shrink();
+    return true;
+  }
+
+  // Returns whether key was present.
+  bool erase(const K& key)
+  {
+    size_t h = index.hash_of(key);
+    TPosition it = index.find(key, h);
+    if (it == TPosition())
+      return false;
+    Remove(it, h);
+    return true;
+  }
+
+  void clear() noexcept
+  {
+    index.clear();
+    entries.clear();
+    totalWeight = 0;
+  }
+
+  // Changes the limits, evicting least recently used entries as needed.
+  void set_capacity(size_t count, size_t weightLimit = Unlimited)
+  {
+    if (count == 0)
+      throw std::invalid_argument("TLruCache capacity must be positive");
+    maxCount = count;
+    maxWeight = weightLimit;
+    if (count != Unlimited)
+      index.reserve(count < 1024 ? count : 1024);
+    Shrink();
+  }
+
+  // Lookup statistics since construction or the last reset_stats().
+  uint64_t hits() const noexcept { return hitCount; }
+  uint64_t misses() const noexcept { return missCount; }
+  uint64_t evictions() const noexcept { return evictCount; }
+
+  double hit_ratio() const noexcept
+  {
+    uint64_t total = hitCount + missCount;
+    return total == 0 ? 0.0 : double(hitCount) / double(total);
+  }
+
+  void reset_stats() noexcept
+  {
+    hitCount = 0;
+    missCount = 0;
+    evictCount = 0;
+  }
+
+private:
+  TEntries entries;
+  TIndex index;
+  Weigher weigher;
+  size_t maxCount = 0;
+  size_t maxWeight = Unlimited;
+  size_t totalWeight = 0;
+  uint64_t hitCount = 0;
+  uint64_t missCount = 0;
+  uint64_t evictCount = 0;
+
+  void Remove(TPosition it, size_t h)
+  {
+    totalWeight -= it->weight;
+    index.erase(it, h);
+    entries.erase(it);
+  }
+
+  void Shrink()
+  {
+    while (!entries.empty() && (entries.size() > maxCount || totalWeight > maxWeight))
+    {
+      TPosition last = std::prev(entries.end());
+      Remove(last, index.hash_of(last->key));
+      evictCount++;
+    }
+  }
+};
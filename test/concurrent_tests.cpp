@@ -0,0 +1,741 @@
+#include "gtest.h"
+#include "tlist.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+TEST(TMpscList, new_queue_is_empty)
+{
+  TMpscList<int> q;
+  int v;
+
+  EXPECT_TRUE(q.empty());
+  EXPECT_FALSE(q.try_pop(v));
+}
+
+TEST(TMpscList, pops_in_fifo_order)
+{
+  TMpscList<int> q;
+  int v;
+
+  for (int i = 0; i < 5; i++)
+    q.push(i);
+
+  for (int i = 0; i < 5; i++)
+  {
+    ASSERT_TRUE(q.try_pop(v));
+    EXPECT_EQ(i, v);
+  }
+  EXPECT_TRUE(q.empty());
+  EXPECT_FALSE(q.try_pop(v));
+}
+
+TEST(TMpscList, can_alternate_push_and_pop)
+{
+  TMpscList<std::string> q;
+  std::string v;
+
+  for (int i = 0; i < 100; i++)
+  {
+    q.push(std::to_string(i));
+    ASSERT_TRUE(q.try_pop(v));
+    EXPECT_EQ(std::to_string(i), v);
+  }
+  EXPECT_TRUE(q.empty());
+}
+
+namespace
+{
+  // Value whose assignment throws while failAssign is set.
+  struct TFlakyValue
+  {
+    static bool failAssign;
+    int v = 0;
+
+    TFlakyValue() = default;
+    TFlakyValue(int x) : v(x) {}
+    TFlakyValue(const TFlakyValue&) = default;
+    TFlakyValue& operator=(const TFlakyValue& o)
+    {
+      if (failAssign)
+        throw std::runtime_error("assign");
+      v = o.v;
+      return *this;
+    }
+  };
+
+  bool TFlakyValue::failAssign = false;
+}
+
+TEST(TMpscList, failed_pop_keeps_the_element)
+{
+  TMpscList<TFlakyValue> q;
+  q.push(1);
+  q.push(2);
+  TFlakyValue out;
+
+  TFlakyValue::failAssign = true;
+  EXPECT_THROW(q.try_pop(out), std::runtime_error);
+  TFlakyValue::failAssign = false;
+
+  EXPECT_FALSE(q.empty());
+  ASSERT_TRUE(q.try_pop(out));
+  EXPECT_EQ(1, out.v);
+  ASSERT_TRUE(q.try_pop(out));
+  EXPECT_EQ(2, out.v);
+  EXPECT_TRUE(q.empty());
+}
+
+TEST(TMpscList, destructor_frees_remaining_elements)
+{
+  auto p = std::make_shared<int>(1);
+  {
+    TMpscList<std::shared_ptr<int>> q;
+    q.push(p);
+    q.push(p);
+  }
+
+  EXPECT_EQ(1, p.use_count());
+}
+
+TEST(TMpscList, many_producers_lose_and_duplicate_nothing)
+{
+  const int producers = 8;
+  const int perProducer = 20000;
+  TMpscList<std::pair<int, int>> q;
+  std::vector<std::thread> threads;
+
+  for (int p = 0; p < producers; p++)
+    threads.emplace_back([&q, p]() {
+      for (int i = 0; i < perProducer; i++)
+        q.push({ p, i });
+    });
+
+  std::vector<int> next(producers, 0);
+  int received = 0;
+  bool ordered = true;
+  std::pair<int, int> v;
+  while (received < producers * perProducer)
+    if (q.try_pop(v))
+    {
+      // Each producer's elements must arrive in the order it pushed them.
+      ordered = ordered && v.second == next[v.first];
+      next[v.first] = v.second + 1;
+      received++;
+    }
+    else
+      std::this_thread::yield();
+  for (auto& t : threads)
+    t.join();
+
+  EXPECT_TRUE(ordered);
+  for (int p = 0; p < producers; p++)
+    EXPECT_EQ(perProducer, next[p]);
+  EXPECT_TRUE(q.empty());
+  EXPECT_FALSE(q.try_pop(v));
+}
+
+TEST(TConcurrentSortedList, behaves_as_sorted_set)
+{
+  TConcurrentSortedList<int> l;
+  std::vector<int> v;
+
+  EXPECT_TRUE(l.insert(3));
+  EXPECT_TRUE(l.insert(1));
+  EXPECT_TRUE(l.insert(2));
+  EXPECT_FALSE(l.insert(2));
+  EXPECT_TRUE(l.contains(1));
+  EXPECT_FALSE(l.contains(4));
+  EXPECT_TRUE(l.erase(1));
+  EXPECT_FALSE(l.erase(1));
+  EXPECT_FALSE(l.contains(1));
+  l.for_each([&v](int x) { v.push_back(x); });
+
+  EXPECT_EQ(std::vector<int>({ 2, 3 }), v);
+}
+
+TEST(TConcurrentSortedList, can_use_custom_comparator)
+{
+  TConcurrentSortedList<int, std::greater<int>> l;
+  std::vector<int> v;
+
+  for (int i = 0; i < 5; i++)
+    l.insert(i);
+  l.for_each([&v](int x) { v.push_back(x); });
+
+  EXPECT_EQ(std::vector<int>({ 4, 3, 2, 1, 0 }), v);
+}
+
+namespace
+{
+struct TTracked
+{
+  int key;
+  std::shared_ptr<int> token;
+
+  bool operator<(const TTracked& other) const { return key < other.key; }
+};
+}
+
+TEST(TConcurrentSortedList, frees_live_and_retired_nodes)
+{
+  auto token = std::make_shared<int>(0);
+  {
+    TConcurrentSortedList<TTracked> l;
+    for (int i = 0; i < 200; i++)
+      l.insert({ i, token });
+    for (int i = 0; i < 200; i += 2)
+      l.erase({ i, nullptr });
+    l.collect();
+  }
+
+  EXPECT_EQ(1, token.use_count());
+}
+
+TEST(TConcurrentSortedList, collect_frees_retired_nodes_when_quiet)
+{
+  auto token = std::make_shared<int>(0);
+  TConcurrentSortedList<TTracked> l;
+
+  for (int i = 0; i < 10; i++)
+    l.insert({ i, token });
+  for (int i = 0; i < 10; i++)
+    l.erase({ i, nullptr });
+  l.collect();
+
+  EXPECT_EQ(1, token.use_count());
+}
+
+TEST(TConcurrentSortedList, racing_inserts_and_erases_of_same_keys_succeed_once)
+{
+  const int threadCount = 4;
+  const int keys = 2000;
+  TConcurrentSortedList<int> l;
+  std::atomic<int> inserted{ 0 };
+  std::atomic<int> erased{ 0 };
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < threadCount; t++)
+    threads.emplace_back([&]() {
+      for (int k = 0; k < keys; k++)
+        inserted += l.insert(k);
+      for (int k = 0; k < keys; k++)
+        erased += l.erase(k);
+    });
+  for (auto& t : threads)
+    t.join();
+
+  EXPECT_LE(keys, inserted.load());
+  EXPECT_EQ(inserted.load(), erased.load());
+  int left = 0;
+  l.for_each([&left](int) { left++; });
+  EXPECT_EQ(0, left);
+}
+
+TEST(TConcurrentSortedList, stress_with_concurrent_readers_keeps_set_consistent)
+{
+  const int writers = 4;
+  const int keysPerWriter = 256;
+  const int opsPerWriter = 20000;
+  TConcurrentSortedList<int> l;
+  std::vector<std::vector<char>> expected(writers, std::vector<char>(keysPerWriter, 0));
+  std::atomic<bool> done{ false };
+  std::atomic<bool> consistent{ true };
+  std::vector<std::thread> threads;
+
+  // Writer w owns the keys congruent to w, so it knows what must be present.
+  for (int w = 0; w < writers; w++)
+    threads.emplace_back([&, w]() {
+      std::mt19937 rng(w);
+      for (int i = 0; i < opsPerWriter; i++)
+      {
+        int k = static_cast<int>(rng() % keysPerWriter);
+        int key = k * writers + w;
+        if (rng() % 2)
+        {
+          bool added = l.insert(key);
+          if (added == static_cast<bool>(expected[w][k]))
+            consistent = false;
+          expected[w][k] = 1;
+        }
+        else
+        {
+          bool removed = l.erase(key);
+          if (removed != static_cast<bool>(expected[w][k]))
+            consistent = false;
+          expected[w][k] = 0;
+        }
+      }
+    });
+  for (int r = 0; r < 2; r++)
+    threads.emplace_back([&]() {
+      while (!done)
+      {
+        int prev = -1;
+        l.for_each([&](int x) {
+          if (x <= prev)
+            consistent = false;
+          prev = x;
+        });
+        l.contains(prev / 2);
+      }
+    });
+  for (int w = 0; w < writers; w++)
+    threads[w].join();
+  done = true;
+  for (size_t t = writers; t < threads.size(); t++)
+    threads[t].join();
+
+  EXPECT_TRUE(consistent);
+  for (int w = 0; w < writers; w++)
+    for (int k = 0; k < keysPerWriter; k++)
+      EXPECT_EQ(static_cast<bool>(expected[w][k]), l.contains(k * writers + w));
+}
+
+TEST(TLockCoupledList, behaves_as_sorted_set)
+{
+  TLockCoupledList<int> l;
+  std::vector<int> v;
+
+  EXPECT_TRUE(l.insert(3));
+  EXPECT_TRUE(l.insert(1));
+  EXPECT_TRUE(l.insert(2));
+  EXPECT_FALSE(l.insert(2));
+  EXPECT_TRUE(l.contains(1));
+  EXPECT_FALSE(l.contains(4));
+  EXPECT_TRUE(l.erase(1));
+  EXPECT_FALSE(l.erase(1));
+  EXPECT_FALSE(l.erase(7));
+  l.for_each([&v](int x) { v.push_back(x); });
+
+  EXPECT_EQ(std::vector<int>({ 2, 3 }), v);
+}
+
+TEST(TLockCoupledList, frees_its_nodes)
+{
+  auto token = std::make_shared<int>(0);
+  {
+    TLockCoupledList<TTracked> l;
+    for (int i = 0; i < 100; i++)
+      l.insert({ i, token });
+    l.insert({ 5, token });
+    for (int i = 0; i < 100; i += 3)
+      l.erase({ i, nullptr });
+  }
+
+  EXPECT_EQ(1, token.use_count());
+}
+
+TEST(TLockCoupledList, concurrent_inserts_build_sorted_set)
+{
+  const int threadCount = 4;
+  const int perThread = 1000;
+  TLockCoupledList<int> l;
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < threadCount; t++)
+    threads.emplace_back([&l, t]() {
+      for (int i = 0; i < perThread; i++)
+        l.insert(i * threadCount + t);
+    });
+  for (auto& t : threads)
+    t.join();
+
+  std::vector<int> v;
+  l.for_each([&v](int x) { v.push_back(x); });
+  ASSERT_EQ(size_t(threadCount * perThread), v.size());
+  for (int i = 0; i < threadCount * perThread; i++)
+    EXPECT_EQ(i, v[i]);
+}
+
+TEST(TLockCoupledList, stress_with_concurrent_readers_keeps_set_consistent)
+{
+  const int writers = 4;
+  const int keysPerWriter = 128;
+  const int opsPerWriter = 10000;
+  TLockCoupledList<int> l;
+  std::vector<std::vector<char>> expected(writers, std::vector<char>(keysPerWriter, 0));
+  std::atomic<bool> done{ false };
+  std::atomic<bool> consistent{ true };
+  std::vector<std::thread> threads;
+
+  for (int w = 0; w < writers; w++)
+    threads.emplace_back([&, w]() {
+      std::mt19937 rng(w);
+      for (int i = 0; i < opsPerWriter; i++)
+      {
+        int k = static_cast<int>(rng() % keysPerWriter);
+        int key = k * writers + w;
+        bool insert = rng() % 2;
+        bool changed = insert ? l.insert(key) : l.erase(key);
+        if (changed != (insert != static_cast<bool>(expected[w][k])))
+          consistent = false;
+        expected[w][k] = insert;
+      }
+    });
+  threads.emplace_back([&]() {
+    while (!done)
+    {
+      int prev = -1;
+      l.for_each([&](int x) {
+        if (x <= prev)
+          consistent = false;
+        prev = x;
+      });
+    }
+  });
+  for (int w = 0; w < writers; w++)
+    threads[w].join();
+  done = true;
+  threads.back().join();
+
+  EXPECT_TRUE(consistent);
+  for (int w = 0; w < writers; w++)
+    for (int k = 0; k < keysPerWriter; k++)
+      EXPECT_EQ(static_cast<bool>(expected[w][k]), l.contains(k * writers + w));
+}
+
+TEST(TRcuList, supports_read_and_write_operations)
+{
+  TRcuList<int> l{ 2, 3 };
+  std::vector<int> v;
+  int found = 0;
+
+  l.push_front(1);
+  l.push_back(4);
+  EXPECT_EQ(2u, l.replace_if([](int x) { return x % 2 == 0; }, 0));
+  EXPECT_EQ(1u, l.remove_if([](int x) { return x == 3; }));
+  l.push_back(5);
+  l.for_each([&v](int x) { v.push_back(x); });
+
+  EXPECT_EQ(std::vector<int>({ 1, 0, 0, 5 }), v);
+  EXPECT_EQ(4u, l.size());
+  EXPECT_TRUE(l.find_if([](int x) { return x > 1; }, found));
+  EXPECT_EQ(5, found);
+  EXPECT_FALSE(l.find_if([](int x) { return x > 5; }, found));
+}
+
+TEST(TRcuList, can_iterate_under_read_lock)
+{
+  TRcuList<int> l{ 1, 2, 3 };
+
+  auto guard = l.read_lock();
+  std::vector<int> v(l.begin(), l.end());
+
+  EXPECT_EQ(std::vector<int>({ 1, 2, 3 }), v);
+}
+
+TEST(TRcuList, clear_then_push_back_starts_new_list)
+{
+  TRcuList<int> l{ 1, 2 };
+  std::vector<int> v;
+
+  l.clear();
+  l.push_back(3);
+  l.for_each([&v](int x) { v.push_back(x); });
+
+  EXPECT_TRUE(v == std::vector<int>({ 3 }));
+  EXPECT_EQ(1u, l.size());
+}
+
+TEST(TRcuList, synchronize_frees_unlinked_nodes)
+{
+  auto token = std::make_shared<int>(0);
+  TRcuList<std::shared_ptr<int>> l;
+
+  for (int i = 0; i < 10; i++)
+    l.push_back(token);
+  l.remove_if([](const std::shared_ptr<int>&) { return true; });
+  l.synchronize();
+
+  EXPECT_EQ(1, token.use_count());
+  EXPECT_TRUE(l.empty());
+}
+
+TEST(TRcuList, reader_keeps_unlinked_node_alive_until_it_unlocks)
+{
+  auto token = std::make_shared<int>(0);
+  TRcuList<std::shared_ptr<int>> l;
+  std::atomic<bool> pinned{ false };
+  std::atomic<bool> release{ false };
+  l.push_back(token);
+
+  std::thread reader([&]() {
+    auto guard = l.read_lock();
+    auto it = l.begin();
+    pinned = true;
+    while (!release)
+      std::this_thread::yield();
+    EXPECT_EQ(token, *it);
+  });
+  while (!pinned)
+    std::this_thread::yield();
+  l.remove_if([](const std::shared_ptr<int>&) { return true; });
+
+  EXPECT_EQ(2, token.use_count());
+  release = true;
+  reader.join();
+  l.synchronize();
+  EXPECT_EQ(1, token.use_count());
+}
+
+namespace
+{
+// Element that records its own destruction, and an allocator that never
+// reuses memory, so a reader reaching a freed node sees Dead rather than
+// somebody else's data.
+struct TCanary
+{
+  static const uint32_t Alive = 0x600d600d;
+  static const uint32_t Dead = 0xdeaddead;
+
+  int key;
+  std::atomic<uint32_t> state{ Alive };
+
+  explicit TCanary(int k) : key(k) {}
+  TCanary(const TCanary& other) : key(other.key) {}
+  TCanary& operator=(const TCanary& other)
+  {
+    key = other.key;
+    return *this;
+  }
+  ~TCanary() { state.store(Dead, std::memory_order_relaxed); }
+};
+
+struct TQuarantine
+{
+  std::mutex m;
+  std::vector<void*> blocks;
+  std::atomic<size_t> freed{ 0 };
+
+  ~TQuarantine()
+  {
+    for (void* p : blocks)
+      ::operator delete(p);
+  }
+};
+
+template <class T>
+struct TQuarantineAllocator
+{
+  using value_type = T;
+
+  TQuarantine* pQuarantine;
+
+  explicit TQuarantineAllocator(TQuarantine* q) : pQuarantine(q) {}
+  template <class U>
+  TQuarantineAllocator(const TQuarantineAllocator<U>& other) : pQuarantine(other.pQuarantine) {}
+
+  T* allocate(size_t n) { return static_cast<T*>(::operator new(n * sizeof(T))); }
+
+  void deallocate(T* p, size_t)
+  {
+    std::lock_guard<std::mutex> lock(pQuarantine->m);
+    pQuarantine->blocks.push_back(p);
+    pQuarantine->freed++;
+  }
+
+  template <class U>
+  bool operator==(const TQuarantineAllocator<U>& other) const { return pQuarantine == other.pQuarantine; }
+  template <class U>
+  bool operator!=(const TQuarantineAllocator<U>& other) const { return pQuarantine != other.pQuarantine; }
+};
+}
+
+TEST(TRcuList, readers_never_observe_freed_nodes)
+{
+  const int keys = 64;
+  const int rounds = 3000;
+  TQuarantine quarantine;
+  std::atomic<bool> done{ false };
+  std::atomic<bool> clean{ true };
+  std::atomic<size_t> freedWhileReading{ 0 };
+  {
+    TRcuList<TCanary, TQuarantineAllocator<TCanary>> l{ TQuarantineAllocator<TCanary>(&quarantine) };
+    for (int k = 0; k < keys; k++)
+      l.push_back(TCanary(k));
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; r++)
+      readers.emplace_back([&]() {
+        while (!done)
+        {
+          auto guard = l.read_lock();
+          for (const TCanary& c : l)
+            if (c.state.load(std::memory_order_relaxed) != TCanary::Alive)
+              clean = false;
+        }
+      });
+
+    std::mt19937 rng(1);
+    for (int i = 0; i < rounds; i++)
+    {
+      int k = static_cast<int>(rng() % keys);
+      auto isKey = [k](const TCanary& c) { return c.key == k; };
+      if (i % 2)
+        l.replace_if(isKey, TCanary(k));
+      else if (l.remove_if(isKey) > 0)
+        l.push_front(TCanary(k));
+    }
+    freedWhileReading = quarantine.freed.load();
+    done = true;
+    for (auto& t : readers)
+      t.join();
+    l.synchronize();
+
+    EXPECT_EQ(size_t(keys), l.size());
+    EXPECT_EQ(size_t(rounds), quarantine.freed.load());
+  }
+
+  EXPECT_TRUE(clean);
+  EXPECT_LT(0u, freedWhileReading.load());
+}
+
+TEST(TListParallel, parallel_for_each_visits_every_element_once)
+{
+  TList<int> l;
+  for (int i = 0; i < 10000; i++)
+    l.push_back(i);
+
+  tlist::parallel_for_each(l, [](int& x) { x *= 2; }, 4);
+
+  int i = 0;
+  for (int x : l)
+    EXPECT_EQ(2 * i++, x);
+}
+
+TEST(TListParallel, parallel_for_each_works_on_other_lists_and_short_lists)
+{
+  TUnrolledList<int, 4> u;
+  for (int i = 0; i < 5000; i++)
+    u.push_back(i);
+  TIndexList<int> small{ 1, 2, 3 };
+  std::atomic<long> sum{ 0 };
+
+  tlist::parallel_for_each(u, [&sum](int x) { sum += x; }, 3);
+  tlist::parallel_for_each(small, [](int& x) { x = -x; });
+
+  EXPECT_EQ(5000L * 4999 / 2, sum.load());
+  EXPECT_EQ(TIndexList<int>({ -1, -2, -3 }), small);
+}
+
+TEST(TListParallel, parallel_transform_writes_matching_positions)
+{
+  TList<int> in;
+  for (int i = 0; i < 7000; i++)
+    in.push_back(i);
+  TList<std::string> out(in.size(), "");
+
+  tlist::parallel_transform(in, out, [](int x) { return std::to_string(x); }, 4);
+
+  int i = 0;
+  for (const std::string& s : out)
+    EXPECT_EQ(std::to_string(i++), s);
+}
+
+TEST(TListParallel, parallel_transform_can_work_in_place)
+{
+  TList<int> l;
+  for (int i = 0; i < 3000; i++)
+    l.push_back(i);
+
+  tlist::parallel_transform(l, l, [](int x) { return x + 1; }, 2);
+
+  EXPECT_EQ(1, l.front());
+  EXPECT_EQ(3000, l.back());
+}
+
+TEST(TListParallel, parallel_transform_throws_when_sizes_differ)
+{
+  TList<int> in{ 1, 2 };
+  TList<int> out{ 1 };
+
+  EXPECT_THROW(tlist::parallel_transform(in, out, [](int x) { return x; }), std::invalid_argument);
+}
+
+TEST(TListParallel, parallel_for_each_rethrows_worker_exception)
+{
+  TList<int> l;
+  for (int i = 0; i < 10000; i++)
+    l.push_back(i);
+
+  EXPECT_THROW(tlist::parallel_for_each(l, [](int x) {
+    if (x == 9999)
+      throw std::runtime_error("last");
+  }, 4), std::runtime_error);
+}
+
+TEST(TList, const_positional_reads_can_run_concurrently)
+{
+  TList<int> l;
+  TRankedList<int> r;
+  for (int i = 0; i < 2000; i++)
+  {
+    l.push_back(i);
+    r.push_back(i);
+  }
+  // A range splice leaves the skip index stale.
+  r.splice(r.end(), r, r.begin(), std::next(r.begin()));
+  EXPECT_EQ(1000, l[1000]);
+  const TList<int>& cl = l;
+  const TRankedList<int>& cr = r;
+  std::atomic<int> mismatches{ 0 };
+
+  // Neither the cursor nor a stale skip index is written by const access.
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; t++)
+    readers.emplace_back([&, t]() {
+      for (int i = t; i < 2000; i += 7)
+      {
+        if (cl[i] != i || cl.at(1999 - i) != 1999 - i)
+          mismatches++;
+        if (cr[i] != (i + 1) % 2000)
+          mismatches++;
+      }
+    });
+  for (std::thread& t : readers)
+    t.join();
+
+  EXPECT_EQ(0, mismatches.load());
+}
+
+namespace
+{
+  // Thread for RunParts that fails to start once its budget is used up.
+  struct TLimitedThread
+  {
+    static int budget;
+    std::thread t;
+
+    template <class F, class... Args>
+    explicit TLimitedThread(F&& f, Args&&... args)
+    {
+      if (budget-- <= 0)
+        throw std::system_error(std::make_error_code(std::errc::resource_unavailable_try_again));
+      t = std::thread(std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    void join() { t.join(); }
+  };
+
+  int TLimitedThread::budget = 0;
+}
+
+TEST(TListParallel, parts_without_a_thread_run_on_the_caller)
+{
+  std::vector<std::atomic<int>> visits(8);
+  auto body = [&visits](size_t i) { visits[i]++; };
+
+  TLimitedThread::budget = 3;
+  tlist::RunParts<TLimitedThread>(visits.size(), body);
+
+  for (std::atomic<int>& v : visits)
+    EXPECT_EQ(1, v.load());
+}
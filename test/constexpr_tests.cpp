@@ -0,0 +1,91 @@
+#include "gtest.h"
+#include "tlist.h"
+
+#include <string>
+
+// Each helper builds and destroys its lists inside one call, so under C++20
+// it can run during constant evaluation; the same helpers also run as
+// ordinary tests, which covers C++17 builds.
+namespace
+{
+  TLIST_CONSTEXPR int BuildAndWalk()
+  {
+    TList<int> l{ 3, 1, 2 };
+    l.push_front(0);
+    l.push_back(9);
+    l.erase(std::next(l.begin()));
+    l.insert(l.end(), 5);
+    int digits = 0;
+    for (int v : l)
+      digits = digits * 10 + v;
+    return digits;
+  }
+
+  TLIST_CONSTEXPR int WalkBackward()
+  {
+    TList<int> l{ 1, 2, 3 };
+    int digits = 0;
+    for (auto it = l.rbegin(); it != l.rend(); ++it)
+      digits = digits * 10 + *it;
+    return digits;
+  }
+
+  TLIST_CONSTEXPR bool CopiesAndMoves()
+  {
+    TList<int> a{ 1, 2, 3 };
+    TList<int> b = a;
+    TList<int> c = std::move(a);
+    b.pop_front();
+    c = b;
+    b.clear();
+    return a.empty() && b.empty() && c == TList<int>{ 2, 3 } && c.front() == 2 && c.back() == 3;
+  }
+
+  TLIST_CONSTEXPR int Positional()
+  {
+    TList<int> l(4, 7);
+    l.insert_at(2, 1);
+    l.erase_at(0);
+    return l[1] * 10 + int(l.size());
+  }
+
+  TLIST_CONSTEXPR size_t NonTrivialValues()
+  {
+    TList<std::string> l{ "ab", "cde" };
+    l.emplace_back(3, 'x');
+    l.emplace_front("q");
+    size_t n = 0;
+    for (const std::string& s : l)
+      n += s.size();
+    return n;
+  }
+
+  TLIST_CONSTEXPR int Spliced()
+  {
+    TList<int> a{ 1, 2 };
+    TList<int> b{ 3, 4 };
+    a.splice(a.end(), b);
+    a.splice(a.begin(), a, std::prev(a.end()));
+    a.swap(b);
+    return int(a.size()) * 10000 + b.front() * 1000 + b.back() * 100 + int(b.size());
+  }
+
+#if TLIST_HAS_CONSTEXPR
+  static_assert(BuildAndWalk() == 1295);
+  static_assert(WalkBackward() == 321);
+  static_assert(CopiesAndMoves());
+  static_assert(Positional() == 14);
+  static_assert(NonTrivialValues() == 9);
+  static_assert(Spliced() == 4304);
+#endif
+}
+
+TEST(TListConstexpr, helpers_give_same_results_at_run_time)
+{
+  EXPECT_EQ(1295, BuildAndWalk());
+  EXPECT_EQ(321, WalkBackward());
+  EXPECT_TRUE(CopiesAndMoves());
+  EXPECT_EQ(14, Positional());
+  EXPECT_EQ(9u, NonTrivialValues());
+  EXPECT_EQ(4304, Spliced());
+}
@@ -0,0 +1,128 @@
+#include "gtest.h"
+#include "tlist.h"
+
+#include <algorithm>
+#include <vector>
+
+// Every list in tlist.h shares the same bidirectional iterator interface, so
+// the iterator tests run over all of them.
+template <class L>
+class TListIteratorTest : public ::testing::Test
+{
+};
+
+typedef ::testing::Types<TList<int>, TIndexList<int>, TUnrolledList<int, 4>, TSmallList<int, 2>,
+                         TStaticList<int, 16>, TXorList<int>>
+  TIteratorLists;
+TYPED_TEST_CASE(TListIteratorTest, TIteratorLists);
+
+TYPED_TEST(TListIteratorTest, begin_equals_end_for_empty_list)
+{
+  TypeParam l;
+
+  EXPECT_EQ(l.begin(), l.end());
+  EXPECT_EQ(l.cbegin(), l.cend());
+}
+
+TYPED_TEST(TListIteratorTest, can_iterate_forward)
+{
+  TypeParam l{ 1, 2, 3 };
+  std::vector<int> v;
+
+  for (int x : l)
+    v.push_back(x);
+
+  EXPECT_EQ(std::vector<int>({ 1, 2, 3 }), v);
+}
+
+TYPED_TEST(TListIteratorTest, can_iterate_backward)
+{
+  TypeParam l{ 1, 2, 3 };
+
+  std::vector<int> v(l.rbegin(), l.rend());
+
+  EXPECT_EQ(std::vector<int>({ 3, 2, 1 }), v);
+}
+
+TYPED_TEST(TListIteratorTest, can_modify_element_through_iterator)
+{
+  TypeParam l{ 1, 2, 3 };
+
+  for (auto it = l.begin(); it != l.end(); ++it)
+    *it *= 2;
+
+  EXPECT_EQ(TypeParam({ 2, 4, 6 }), l);
+}
+
+TYPED_TEST(TListIteratorTest, iterator_converts_to_const_iterator)
+{
+  TypeParam l{ 1 };
+
+  typename TypeParam::const_iterator it = l.begin();
+
+  EXPECT_EQ(l.cbegin(), it);
+}
+
+TYPED_TEST(TListIteratorTest, postfix_increment_returns_old_position)
+{
+  TypeParam l{ 1, 2 };
+  auto it = l.begin();
+
+  EXPECT_EQ(1, *it++);
+  EXPECT_EQ(2, *it);
+}
+
+TYPED_TEST(TListIteratorTest, decrement_from_end_reaches_last_element)
+{
+  TypeParam l{ 1, 2, 3 };
+  auto it = l.end();
+
+  --it;
+
+  EXPECT_EQ(3, *it);
+  EXPECT_EQ(2, *--it);
+}
+
+TYPED_TEST(TListIteratorTest, insert_returns_iterator_to_new_element)
+{
+  TypeParam l{ 1, 3 };
+
+  auto it = l.insert(std::next(l.begin()), 2);
+
+  EXPECT_EQ(2, *it);
+  EXPECT_EQ(3, *++it);
+}
+
+TYPED_TEST(TListIteratorTest, works_with_std_algorithms)
+{
+  TypeParam l{ 4, 1, 3 };
+
+  auto it = std::find(l.begin(), l.end(), 3);
+
+  EXPECT_EQ(3, *it);
+  EXPECT_EQ(1, *std::min_element(l.begin(), l.end()));
+}
+
+TEST(TListIterator, iterators_stay_valid_after_insert)
+{
+  TList<int> l{ 1, 3 };
+  auto it = ++l.begin();
+
+  l.insert(it, 2);
+  l.push_front(0);
+
+  EXPECT_EQ(3, *it);
+}
+
+TEST(TIndexListIterator, iterators_stay_valid_when_array_grows)
+{
+  TIndexList<int> l{ 1, 2 };
+  auto it = ++l.begin();
+  size_t cap = l.capacity();
+
+  for (int i = 0; i < 100; i++)
+    l.push_front(i);
+
+  EXPECT_LT(cap, l.capacity());
+  EXPECT_EQ(2, *it);
+}
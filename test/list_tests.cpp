@@ -1,3 +1,2421 @@
 #include "gtest.h"
 #include "tlist.h"
 
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <limits>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <string>
+#include <sstream>
+
+namespace
+{
+  // Per-test allocation bookkeeping shared by every rebound copy of
+  // TCountingAllocator created from the same instance.
+  struct TAllocStats
+  {
+    size_t allocs = 0;
+    size_t frees = 0;
+    size_t live = 0;
+    size_t lastSize = 0;
+  };
+
+  template <class T>
+  struct TCountingAllocator
+  {
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    TAllocStats* stats;
+
+    explicit TCountingAllocator(TAllocStats* s) : stats(s) {}
+    template <class U>
+    TCountingAllocator(const TCountingAllocator<U>& o) : stats(o.stats) {}
+
+    T* allocate(size_t n)
+    {
+      stats->allocs++;
+      stats->live += n;
+      stats->lastSize = n * sizeof(T);
+      return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n)
+    {
+      stats->frees++;
+      stats->live -= n;
+      ::operator delete(p);
+    }
+
+    template <class U>
+    bool operator==(const TCountingAllocator<U>& o) const { return stats == o.stats; }
+    template <class U>
+    bool operator!=(const TCountingAllocator<U>& o) const { return stats != o.stats; }
+  };
+
+  using TCountingList = TList<int, TCountingAllocator<int>>;
+}
+
+TEST(TList, can_create_empty_list)
+{
+  ASSERT_NO_THROW(TList<int> l);
+}
+
+TEST(TList, new_list_is_empty)
+{
+  TList<int> l;
+
+  EXPECT_TRUE(l.empty());
+  EXPECT_EQ(0u, l.size());
+  EXPECT_EQ(l.begin(), l.end());
+}
+
+TEST(TList, can_create_list_from_initializer_list)
+{
+  TList<int> l{ 1, 2, 3 };
+
+  EXPECT_EQ(3u, l.size());
+  EXPECT_EQ(1, l.front());
+  EXPECT_EQ(3, l.back());
+}
+
+TEST(TList, can_create_list_of_repeated_value)
+{
+  TList<int> l(4, 7);
+
+  EXPECT_EQ(4u, l.size());
+  EXPECT_EQ(7, l[3]);
+}
+
+TEST(TList, can_push_front_and_back)
+{
+  TList<int> l;
+
+  l.push_back(2);
+  l.push_front(1);
+  l.push_back(3);
+
+  EXPECT_EQ(TList<int>({ 1, 2, 3 }), l);
+}
+
+TEST(TList, can_pop_front_and_back)
+{
+  TList<int> l{ 1, 2, 3 };
+
+  l.pop_front();
+  l.pop_back();
+
+  EXPECT_EQ(TList<int>({ 2 }), l);
+}
+
+TEST(TList, throws_when_pop_from_empty_list)
+{
+  TList<int> l;
+
+  ASSERT_ANY_THROW(l.pop_front());
+  ASSERT_ANY_THROW(l.pop_back());
+}
+
+TEST(TList, throws_when_front_of_empty_list)
+{
+  TList<int> l;
+
+  ASSERT_ANY_THROW(l.front());
+  ASSERT_ANY_THROW(l.back());
+}
+
+TEST(TList, can_insert_in_the_middle)
+{
+  TList<int> l{ 1, 3 };
+
+  auto it = l.insert(++l.begin(), 2);
+
+  EXPECT_EQ(2, *it);
+  EXPECT_EQ(TList<int>({ 1, 2, 3 }), l);
+}
+
+TEST(TList, can_erase_element)
+{
+  TList<int> l{ 1, 2, 3 };
+
+  auto it = l.erase(++l.begin());
+
+  EXPECT_EQ(3, *it);
+  EXPECT_EQ(TList<int>({ 1, 3 }), l);
+}
+
+TEST(TList, can_erase_range)
+{
+  TList<int> l{ 1, 2, 3, 4 };
+
+  l.erase(++l.begin(), --l.end());
+
+  EXPECT_EQ(TList<int>({ 1, 4 }), l);
+}
+
+TEST(TList, can_emplace_element)
+{
+  TList<std::string> l;
+
+  l.emplace_back(3, 'a');
+
+  EXPECT_EQ("aaa", l.front());
+}
+
+TEST(TList, can_get_element_by_index)
+{
+  TList<int> l{ 5, 6, 7 };
+
+  EXPECT_EQ(6, l[1]);
+  EXPECT_EQ(7, l.at(2));
+}
+
+TEST(TList, throws_when_index_is_out_of_range)
+{
+  TList<int> l{ 5, 6, 7 };
+
+  ASSERT_ANY_THROW(l.at(3));
+}
+
+TEST(TList, can_clear_list)
+{
+  TList<int> l{ 1, 2, 3 };
+
+  l.clear();
+
+  EXPECT_TRUE(l.empty());
+  EXPECT_EQ(l.begin(), l.end());
+}
+
+TEST(TList, copied_list_is_equal_to_source)
+{
+  TList<int> l{ 1, 2, 3 };
+  TList<int> c(l);
+
+  EXPECT_EQ(l, c);
+}
+
+TEST(TList, copied_list_has_its_own_memory)
+{
+  TList<int> l{ 1, 2, 3 };
+  TList<int> c(l);
+
+  c.front() = 10;
+
+  EXPECT_EQ(1, l.front());
+}
+
+TEST(TList, can_assign_list)
+{
+  TList<int> l{ 1, 2, 3 };
+  TList<int> c{ 4 };
+
+  c = l;
+
+  EXPECT_EQ(l, c);
+}
+
+TEST(TList, move_leaves_source_empty)
+{
+  TList<int> l{ 1, 2, 3 };
+  TList<int> m(std::move(l));
+
+  EXPECT_EQ(TList<int>({ 1, 2, 3 }), m);
+  EXPECT_TRUE(l.empty());
+}
+
+TEST(TList, can_move_assign_list)
+{
+  TList<int> l{ 1, 2, 3 };
+  TList<int> m{ 9 };
+
+  m = std::move(l);
+
+  EXPECT_EQ(TList<int>({ 1, 2, 3 }), m);
+  EXPECT_TRUE(l.empty());
+}
+
+TEST(TList, can_swap_lists)
+{
+  TList<int> a{ 1, 2 };
+  TList<int> b{ 3 };
+
+  swap(a, b);
+
+  EXPECT_EQ(TList<int>({ 3 }), a);
+  EXPECT_EQ(TList<int>({ 1, 2 }), b);
+}
+
+TEST(TList, can_swap_with_empty_list)
+{
+  TList<int> a{ 1, 2 };
+  TList<int> b;
+
+  a.swap(b);
+
+  EXPECT_TRUE(a.empty());
+  EXPECT_EQ(TList<int>({ 1, 2 }), b);
+  b.push_back(3);
+  EXPECT_EQ(3, b.back());
+}
+
+TEST(TList, can_print_list)
+{
+  TList<int> l{ 1, 2, 3 };
+  std::ostringstream os;
+
+  os << l;
+
+  EXPECT_EQ("{1, 2, 3}", os.str());
+}
+
+TEST(TList, allocates_one_node_per_push)
+{
+  TAllocStats stats;
+  TCountingList l{ TCountingAllocator<int>(&stats) };
+
+  l.push_back(1);
+  l.push_front(2);
+  l.insert(l.begin(), 3);
+
+  EXPECT_EQ(3u, stats.allocs);
+  EXPECT_EQ(3u, stats.live);
+}
+
+TEST(TList, allocator_is_rebound_to_node_type)
+{
+  TAllocStats stats;
+  TCountingList l{ TCountingAllocator<int>(&stats) };
+
+  l.push_back(1);
+
+  EXPECT_GT(stats.lastSize, sizeof(int));
+}
+
+TEST(TList, frees_node_on_erase)
+{
+  TAllocStats stats;
+  TCountingList l{ TCountingAllocator<int>(&stats) };
+  l.push_back(1);
+  l.push_back(2);
+
+  l.erase(l.begin());
+  l.pop_back();
+
+  EXPECT_EQ(2u, stats.frees);
+  EXPECT_EQ(0u, stats.live);
+}
+
+TEST(TList, destructor_frees_all_nodes)
+{
+  TAllocStats stats;
+  {
+    TCountingList l{ TCountingAllocator<int>(&stats) };
+    for (int i = 0; i < 10; i++)
+      l.push_back(i);
+  }
+
+  EXPECT_EQ(10u, stats.allocs);
+  EXPECT_EQ(10u, stats.frees);
+  EXPECT_EQ(0u, stats.live);
+}
+
+TEST(TList, move_does_not_allocate)
+{
+  TAllocStats stats;
+  TCountingList l{ TCountingAllocator<int>(&stats) };
+  l.push_back(1);
+  l.push_back(2);
+
+  TCountingList m(std::move(l));
+
+  EXPECT_EQ(2u, stats.allocs);
+  EXPECT_EQ(2u, m.size());
+}
+
+TEST(TList, assignment_reuses_existing_nodes)
+{
+  TAllocStats stats;
+  TCountingList a{ TCountingAllocator<int>(&stats) };
+  TCountingList b{ TCountingAllocator<int>(&stats) };
+  for (int i = 0; i < 3; i++)
+  {
+    a.push_back(i);
+    b.push_back(10 + i);
+  }
+
+  a = b;
+
+  EXPECT_EQ(6u, stats.allocs);
+  EXPECT_EQ(0u, stats.frees);
+  EXPECT_EQ(b, a);
+}
+
+TEST(TList, copy_uses_allocator_of_source)
+{
+  TAllocStats stats;
+  TCountingList l{ TCountingAllocator<int>(&stats) };
+  l.push_back(1);
+
+  TCountingList c(l);
+
+  EXPECT_EQ(2u, stats.allocs);
+  EXPECT_TRUE(c.get_allocator() == l.get_allocator());
+}
+
+TEST(TList, assignment_propagates_allocator)
+{
+  TAllocStats s1, s2;
+  TCountingList a{ TCountingAllocator<int>(&s1) };
+  TCountingList b{ TCountingAllocator<int>(&s2) };
+  a.push_back(1);
+  b.push_back(2);
+
+  a = b;
+
+  EXPECT_EQ(0u, s1.live);
+  EXPECT_EQ(2u, s2.live);
+  EXPECT_EQ(&s2, a.get_allocator().stats);
+}
+
+TEST(TPooledList, can_use_list_in_pool_mode)
+{
+  TPooledList<int> l;
+
+  for (int i = 0; i < 5; i++)
+    l.push_back(i);
+  l.pop_front();
+
+  EXPECT_EQ(TPooledList<int>({ 1, 2, 3, 4 }), l);
+}
+
+TEST(TPooledList, carves_nodes_from_slabs)
+{
+  TPooledList<int> l{ TPoolAllocator<int>(16) };
+
+  for (int i = 0; i < 40; i++)
+    l.push_back(i);
+
+  TNodePool::TStats s = l.get_allocator().pool().stats();
+  EXPECT_EQ(3u, s.slabs);
+  EXPECT_EQ(40u, s.liveNodes);
+  EXPECT_EQ(8u, s.freeNodes);
+}
+
+TEST(TPooledList, erased_nodes_go_to_free_list)
+{
+  TPooledList<int> l{ TPoolAllocator<int>(16) };
+  for (int i = 0; i < 10; i++)
+    l.push_back(i);
+
+  l.erase(l.begin());
+  l.pop_back();
+
+  TNodePool::TStats s = l.get_allocator().pool().stats();
+  EXPECT_EQ(8u, s.liveNodes);
+  EXPECT_EQ(8u, s.freeNodes);
+}
+
+TEST(TPooledList, steady_churn_does_not_grow_pool)
+{
+  TPooledList<int> l{ TPoolAllocator<int>(64) };
+  for (int i = 0; i < 50; i++)
+    l.push_back(i);
+  size_t slabs = l.get_allocator().pool().stats().slabs;
+
+  for (int i = 0; i < 10000; i++)
+  {
+    l.erase(l.begin());
+    l.push_back(i);
+  }
+
+  TNodePool::TStats s = l.get_allocator().pool().stats();
+  EXPECT_EQ(slabs, s.slabs);
+  EXPECT_EQ(50u, s.liveNodes);
+  EXPECT_EQ(50u, s.highWater);
+}
+
+TEST(TPooledList, recycles_last_freed_node_first)
+{
+  TPooledList<int> l;
+  l.push_back(1);
+  l.push_back(2);
+  const int* p = &l.front();
+
+  l.pop_front();
+  l.push_back(3);
+
+  EXPECT_EQ(p, &l.back());
+}
+
+TEST(TPooledList, high_water_mark_tracks_peak_size)
+{
+  TPooledList<int> l{ TPoolAllocator<int>(8) };
+
+  for (int i = 0; i < 20; i++)
+    l.push_back(i);
+  l.clear();
+  for (int i = 0; i < 5; i++)
+    l.push_back(i);
+
+  EXPECT_EQ(20u, l.get_allocator().pool().stats().highWater);
+}
+
+TEST(TPooledList, shrink_to_fit_releases_free_slabs)
+{
+  TPooledList<int> l{ TPoolAllocator<int>(8) };
+  for (int i = 0; i < 32; i++)
+    l.push_back(i);
+
+  l.erase(l.begin(), std::next(l.begin(), 24));
+  size_t released = l.get_allocator().pool().shrink_to_fit();
+
+  TNodePool::TStats s = l.get_allocator().pool().stats();
+  EXPECT_EQ(3u, released);
+  EXPECT_EQ(1u, s.slabs);
+  EXPECT_EQ(0u, s.freeNodes);
+  EXPECT_EQ(TPooledList<int>({ 24, 25, 26, 27, 28, 29, 30, 31 }), l);
+}
+
+TEST(TPooledList, shrink_to_fit_keeps_partially_used_slabs)
+{
+  TPooledList<int> l{ TPoolAllocator<int>(8) };
+  for (int i = 0; i < 16; i++)
+    l.push_back(i);
+
+  l.erase(l.begin(), std::next(l.begin(), 4));
+  l.erase(std::next(l.begin(), 8), l.end());
+  size_t released = l.get_allocator().pool().shrink_to_fit();
+
+  TNodePool::TStats s = l.get_allocator().pool().stats();
+  EXPECT_EQ(0u, released);
+  EXPECT_EQ(2u, s.slabs);
+  EXPECT_EQ(8u, s.freeNodes);
+  l.push_back(100);
+  EXPECT_EQ(9u, l.size());
+}
+
+TEST(TPooledList, rejects_array_request_that_overflows)
+{
+  TPoolAllocator<long long> a(8);
+
+  EXPECT_THROW(a.allocate(std::numeric_limits<size_t>::max() / 4), std::bad_array_new_length);
+}
+
+TEST(TPooledList, moved_list_keeps_its_pool)
+{
+  TPooledList<int> l{ TPoolAllocator<int>(8) };
+  l.push_back(1);
+
+  TPooledList<int> m(std::move(l));
+  m.push_back(2);
+
+  EXPECT_TRUE(m.get_allocator() == l.get_allocator());
+  EXPECT_EQ(2u, m.get_allocator().pool().stats().liveNodes);
+}
+
+namespace
+{
+  // Upstream resource that counts what reaches it.
+  class TCountingResource : public std::pmr::memory_resource
+  {
+  public:
+    size_t allocs = 0;
+
+  private:
+    void* do_allocate(size_t bytes, size_t align) override
+    {
+      allocs++;
+      return std::pmr::new_delete_resource()->allocate(bytes, align);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t align) override
+    {
+      std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+  };
+}
+
+TEST(PmrTList, can_use_list_on_stack_buffer)
+{
+  char buf[4096];
+  std::pmr::monotonic_buffer_resource arena(buf, sizeof(buf), std::pmr::null_memory_resource());
+  pmr::TList<int> l(&arena);
+
+  for (int i = 0; i < 50; i++)
+    l.push_back(i);
+  l.erase(l.begin());
+
+  EXPECT_EQ(49u, l.size());
+  EXPECT_EQ(1, l.front());
+}
+
+TEST(PmrTList, nodes_do_not_reach_upstream_resource)
+{
+  TCountingResource upstream;
+  char buf[8192];
+  std::pmr::monotonic_buffer_resource arena(buf, sizeof(buf), &upstream);
+  {
+    pmr::TList<int> l(&arena);
+    for (int i = 0; i < 100; i++)
+      l.push_front(i);
+    l.clear();
+    for (int i = 0; i < 100; i++)
+      l.push_back(i);
+  }
+
+  EXPECT_EQ(0u, upstream.allocs);
+}
+
+TEST(PmrTList, arena_overflow_goes_upstream)
+{
+  TCountingResource upstream;
+  char buf[256];
+  std::pmr::monotonic_buffer_resource arena(buf, sizeof(buf), &upstream);
+  pmr::TList<int> l(&arena);
+
+  for (int i = 0; i < 100; i++)
+    l.push_back(i);
+
+  EXPECT_LT(0u, upstream.allocs);
+}
+
+TEST(PmrTList, elements_use_list_resource)
+{
+  TCountingResource upstream;
+  char buf[8192];
+  std::pmr::monotonic_buffer_resource arena(buf, sizeof(buf), &upstream);
+  pmr::TList<std::pmr::string> l(&arena);
+
+  l.emplace_back(200, 'x');
+
+  EXPECT_EQ(&arena, l.front().get_allocator().resource());
+  EXPECT_EQ(0u, upstream.allocs);
+}
+
+TEST(PmrTList, copy_uses_default_resource)
+{
+  char buf[1024];
+  std::pmr::monotonic_buffer_resource arena(buf, sizeof(buf), std::pmr::null_memory_resource());
+  pmr::TList<int> l({ 1, 2, 3 }, &arena);
+
+  pmr::TList<int> c(l);
+
+  EXPECT_EQ(std::pmr::get_default_resource(), c.get_allocator().resource());
+  EXPECT_EQ(l, c);
+}
+
+TEST(PmrTList, move_to_other_resource_copies_elements)
+{
+  char buf1[1024], buf2[1024];
+  std::pmr::monotonic_buffer_resource a1(buf1, sizeof(buf1), std::pmr::null_memory_resource());
+  std::pmr::monotonic_buffer_resource a2(buf2, sizeof(buf2), std::pmr::null_memory_resource());
+  pmr::TList<int> l({ 1, 2, 3 }, &a1);
+  pmr::TList<int> m(&a2);
+
+  m = std::move(l);
+
+  EXPECT_EQ(&a2, m.get_allocator().resource());
+  EXPECT_EQ(pmr::TList<int>({ 1, 2, 3 }), m);
+}
+
+namespace
+{
+  // Checks a list against a reference sequence, both forward and backward.
+  template <class L>
+  void ExpectSameSequence(const std::vector<int>& ref, const L& l)
+  {
+    ASSERT_EQ(ref.size(), l.size());
+    EXPECT_TRUE(std::equal(ref.begin(), ref.end(), l.begin()));
+    EXPECT_TRUE(std::equal(ref.rbegin(), ref.rend(), l.rbegin()));
+  }
+}
+
+TEST(TUnrolledList, can_create_empty_list)
+{
+  TUnrolledList<int, 4> l;
+
+  EXPECT_TRUE(l.empty());
+  EXPECT_EQ(l.begin(), l.end());
+  EXPECT_EQ(0u, l.node_count());
+}
+
+TEST(TUnrolledList, default_node_fits_cache_line)
+{
+  EXPECT_LE(sizeof(TUnrolledNode<int, TUnrolledDefaultCapacity<int>>), 64u);
+  EXPECT_LE(8u, TUnrolledDefaultCapacity<int>);
+}
+
+TEST(TUnrolledList, push_back_fills_nodes_completely)
+{
+  TUnrolledList<int, 4> l;
+
+  for (int i = 0; i < 10; i++)
+    l.push_back(i);
+
+  EXPECT_EQ(3u, l.node_count());
+  ExpectSameSequence({ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 }, l);
+}
+
+TEST(TUnrolledList, push_front_fills_nodes_completely)
+{
+  TUnrolledList<int, 4> l;
+
+  for (int i = 0; i < 8; i++)
+    l.push_front(i);
+
+  EXPECT_EQ(2u, l.node_count());
+  ExpectSameSequence({ 7, 6, 5, 4, 3, 2, 1, 0 }, l);
+}
+
+TEST(TUnrolledList, insert_into_full_node_splits_it)
+{
+  TUnrolledList<int, 4> l{ 1, 2, 4, 5 };
+
+  auto it = l.insert(std::next(l.begin(), 2), 3);
+
+  EXPECT_EQ(3, *it);
+  EXPECT_EQ(2u, l.node_count());
+  ExpectSameSequence({ 1, 2, 3, 4, 5 }, l);
+}
+
+TEST(TUnrolledList, erase_returns_next_element)
+{
+  TUnrolledList<int, 4> l{ 0, 1, 2, 3, 4, 5, 6, 7 };
+
+  auto it = l.erase(std::next(l.begin(), 3));
+
+  EXPECT_EQ(4, *it);
+  ExpectSameSequence({ 0, 1, 2, 4, 5, 6, 7 }, l);
+}
+
+TEST(TUnrolledList, underflowing_node_merges_with_successor)
+{
+  TUnrolledList<int, 4> l{ 0, 1, 2, 3, 4, 5 };
+
+  l.erase(l.begin());
+  l.erase(l.begin());
+  l.erase(l.begin());
+
+  EXPECT_EQ(1u, l.node_count());
+  ExpectSameSequence({ 3, 4, 5 }, l);
+}
+
+TEST(TUnrolledList, underflowing_node_borrows_from_successor)
+{
+  TUnrolledList<int, 4> l{ 0, 1, 2, 3, 4, 5, 6, 7 };
+
+  l.erase(l.begin());
+  auto it = l.erase(l.begin());
+  it = l.erase(it);
+
+  EXPECT_EQ(3, *it);
+  EXPECT_EQ(2u, l.node_count());
+  ExpectSameSequence({ 3, 4, 5, 6, 7 }, l);
+}
+
+TEST(TUnrolledList, erasing_whole_list_frees_nodes)
+{
+  TUnrolledList<int, 4> l{ 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+
+  auto it = l.erase(l.begin(), l.end());
+
+  EXPECT_EQ(l.end(), it);
+  EXPECT_TRUE(l.empty());
+  EXPECT_EQ(0u, l.node_count());
+}
+
+TEST(TUnrolledList, matches_reference_under_random_edits)
+{
+  TUnrolledList<int, 5> l;
+  std::vector<int> ref;
+  unsigned seed = 12345;
+  auto rnd = [&seed]() { seed = seed * 1103515245u + 12345u; return (seed >> 16) & 0x7fff; };
+
+  for (int step = 0; step < 3000; step++)
+  {
+    if (ref.empty() || rnd() % 3 != 0)
+    {
+      size_t pos = ref.empty() ? 0 : rnd() % (ref.size() + 1);
+      l.insert(std::next(l.begin(), pos), step);
+      ref.insert(ref.begin() + pos, step);
+    }
+    else
+    {
+      size_t pos = rnd() % ref.size();
+      auto it = l.erase(std::next(l.begin(), pos));
+      auto rit = ref.erase(ref.begin() + pos);
+      if (rit == ref.end())
+        EXPECT_EQ(l.end(), it);
+      else
+        EXPECT_EQ(*rit, *it);
+    }
+  }
+
+  ExpectSameSequence(ref, l);
+  EXPECT_LE(l.node_count() * 2, l.size() + 2 * 5);
+}
+
+TEST(TUnrolledList, can_hold_non_trivial_elements)
+{
+  TUnrolledList<std::string, 3> l;
+
+  for (int i = 0; i < 10; i++)
+    l.push_back(std::string(20, char('a' + i)));
+  l.erase(std::next(l.begin(), 4));
+  l.insert(std::next(l.begin(), 1), "x");
+
+  EXPECT_EQ(10u, l.size());
+  EXPECT_EQ("x", *std::next(l.begin()));
+  EXPECT_EQ(std::string(20, 'j'), l.back());
+}
+
+TEST(TUnrolledList, can_copy_and_move_list)
+{
+  TUnrolledList<int, 4> l{ 1, 2, 3, 4, 5 };
+
+  TUnrolledList<int, 4> c(l);
+  TUnrolledList<int, 4> m(std::move(l));
+
+  EXPECT_EQ(c, m);
+  EXPECT_TRUE(l.empty());
+  l.push_back(1);
+  EXPECT_EQ(1u, l.size());
+}
+
+TEST(TUnrolledList, can_pop_from_both_ends)
+{
+  TUnrolledList<int, 4> l{ 1, 2, 3, 4, 5, 6 };
+
+  l.pop_front();
+  l.pop_back();
+
+  ExpectSameSequence({ 2, 3, 4, 5 }, l);
+  EXPECT_EQ(2, l.front());
+  EXPECT_EQ(5, l.back());
+}
+
+TEST(TUnrolledList, can_insert_copy_of_own_element)
+{
+  TUnrolledList<std::string, 4> l{ "aaaaaaaaaaaaaaaaaaaa", "bbbbbbbbbbbbbbbbbbbb", "cccccccccccccccccccc" };
+
+  // The first insert shifts the node's elements, the second splits it.
+  l.push_front(l.front());
+  l.insert(std::next(l.begin(), 2), *std::next(l.begin(), 3));
+
+  std::vector<std::string> expected{ "aaaaaaaaaaaaaaaaaaaa", "aaaaaaaaaaaaaaaaaaaa", "cccccccccccccccccccc",
+                                     "bbbbbbbbbbbbbbbbbbbb", "cccccccccccccccccccc" };
+  EXPECT_EQ(expected, std::vector<std::string>(l.begin(), l.end()));
+}
+
+TEST(TIndexList, new_list_does_not_allocate)
+{
+  TIndexList<int> l;
+
+  EXPECT_TRUE(l.empty());
+  EXPECT_EQ(0u, l.capacity());
+}
+
+TEST(TIndexList, links_are_32_bit)
+{
+  EXPECT_EQ(2 * sizeof(uint32_t) + sizeof(int), sizeof(TIndexNode<int>));
+  EXPECT_LT(sizeof(TIndexNode<int>), sizeof(TListNode<int>));
+}
+
+TEST(TIndexList, can_push_and_pop)
+{
+  TIndexList<int> l;
+
+  l.push_back(2);
+  l.push_front(1);
+  l.push_back(3);
+  l.pop_front();
+
+  EXPECT_EQ(TIndexList<int>({ 2, 3 }), l);
+}
+
+TEST(TIndexList, can_insert_and_erase)
+{
+  TIndexList<int> l{ 1, 2, 4 };
+
+  l.insert(std::next(l.begin(), 2), 3);
+  auto it = l.erase(l.begin());
+
+  EXPECT_EQ(2, *it);
+  EXPECT_EQ(TIndexList<int>({ 2, 3, 4 }), l);
+}
+
+TEST(TIndexList, erased_slots_are_reused)
+{
+  TIndexList<int> l;
+  l.reserve(4);
+  for (int i = 0; i < 4; i++)
+    l.push_back(i);
+  size_t cap = l.capacity();
+
+  for (int i = 0; i < 1000; i++)
+  {
+    l.pop_front();
+    l.push_back(i);
+  }
+
+  EXPECT_EQ(cap, l.capacity());
+  EXPECT_EQ(4u, l.size());
+}
+
+TEST(TIndexList, keeps_elements_when_array_grows)
+{
+  TIndexList<std::string> l;
+
+  for (int i = 0; i < 100; i++)
+    l.push_front(std::to_string(i));
+
+  EXPECT_EQ(100u, l.size());
+  EXPECT_EQ("99", l.front());
+  EXPECT_EQ("0", l.back());
+}
+
+TEST(TIndexList, clear_keeps_capacity)
+{
+  TIndexList<int> l{ 1, 2, 3 };
+  size_t cap = l.capacity();
+
+  l.clear();
+
+  EXPECT_TRUE(l.empty());
+  EXPECT_EQ(cap, l.capacity());
+}
+
+TEST(TIndexList, can_copy_and_move_list)
+{
+  TIndexList<int> l{ 1, 2, 3 };
+
+  TIndexList<int> c(l);
+  TIndexList<int> m(std::move(l));
+
+  EXPECT_EQ(c, m);
+  EXPECT_TRUE(l.empty());
+  EXPECT_EQ(l.begin(), l.end());
+  l.push_back(4);
+  EXPECT_EQ(TIndexList<int>({ 4 }), l);
+}
+
+TEST(TIndexList, can_insert_copy_of_own_element_when_full)
+{
+  TIndexList<std::string> l{ "aaaaaaaaaaaaaaaaaaaa", "bbbbbbbbbbbbbbbbbbbb" };
+  while (l.size() < l.capacity())
+    l.push_back("cccccccccccccccccccc");
+  size_t cap = l.capacity();
+
+  // The array grows while the argument still refers into the old one.
+  l.push_back(l.front());
+
+  EXPECT_LT(cap, l.capacity());
+  EXPECT_EQ("aaaaaaaaaaaaaaaaaaaa", l.back());
+  EXPECT_EQ("bbbbbbbbbbbbbbbbbbbb", *std::next(l.begin()));
+}
+
+TEST(TIndexList, move_to_other_resource_moves_elements)
+{
+  char buf1[1024], buf2[1024];
+  std::pmr::monotonic_buffer_resource a1(buf1, sizeof(buf1), std::pmr::null_memory_resource());
+  std::pmr::monotonic_buffer_resource a2(buf2, sizeof(buf2), std::pmr::null_memory_resource());
+  TIndexList<int, std::pmr::polymorphic_allocator<int>> l({ 1, 2, 3 }, &a1);
+  TIndexList<int, std::pmr::polymorphic_allocator<int>> m({ 9 }, &a2);
+
+  m = std::move(l);
+
+  EXPECT_EQ(&a2, m.get_allocator().resource());
+  EXPECT_EQ(&a1, l.get_allocator().resource());
+  EXPECT_TRUE(l.empty());
+  EXPECT_EQ((std::vector<int>{ 1, 2, 3 }), std::vector<int>(m.begin(), m.end()));
+}
+
+TEST(TIndexList, copy_assignment_propagates_allocator)
+{
+  TAllocStats s1, s2;
+  TIndexList<int, TCountingAllocator<int>> a{ TCountingAllocator<int>(&s1) };
+  TIndexList<int, TCountingAllocator<int>> b{ TCountingAllocator<int>(&s2) };
+  a.push_back(1);
+  b.push_back(2);
+
+  a = b;
+
+  EXPECT_EQ(0u, s1.live);
+  EXPECT_EQ(&s2, a.get_allocator().stats);
+  EXPECT_EQ(2, a.front());
+}
+
+TEST(TIndexList, throws_when_pop_from_empty_list)
+{
+  TIndexList<int> l;
+
+  ASSERT_ANY_THROW(l.pop_back());
+}
+
+TEST(TIndexList, matches_reference_under_random_edits)
+{
+  TIndexList<int> l;
+  std::vector<int> ref;
+  unsigned seed = 777;
+  auto rnd = [&seed]() { seed = seed * 1103515245u + 12345u; return (seed >> 16) & 0x7fff; };
+
+  for (int step = 0; step < 2000; step++)
+  {
+    if (ref.empty() || rnd() % 3 != 0)
+    {
+      size_t pos = rnd() % (ref.size() + 1);
+      l.insert(std::next(l.begin(), pos), step);
+      ref.insert(ref.begin() + pos, step);
+    }
+    else
+    {
+      size_t pos = rnd() % ref.size();
+      l.erase(std::next(l.begin(), pos));
+      ref.erase(ref.begin() + pos);
+    }
+  }
+
+  ExpectSameSequence(ref, l);
+}
+
+TEST(TList, can_splice_whole_list)
+{
+  TList<int> a{ 1, 4 };
+  TList<int> b{ 2, 3 };
+  auto it = b.begin();
+
+  a.splice(++a.begin(), b);
+
+  EXPECT_EQ(TList<int>({ 1, 2, 3, 4 }), a);
+  EXPECT_EQ(4u, a.size());
+  EXPECT_TRUE(b.empty());
+  EXPECT_EQ(b.begin(), b.end());
+  EXPECT_EQ(2, *it);
+  EXPECT_EQ(3, *++it);
+}
+
+TEST(TList, can_splice_empty_list)
+{
+  TList<int> a{ 1 };
+  TList<int> b;
+
+  a.splice(a.end(), b);
+
+  EXPECT_EQ(TList<int>({ 1 }), a);
+}
+
+TEST(TList, can_splice_single_element)
+{
+  TList<int> a{ 1, 3 };
+  TList<int> b{ 5, 2, 6 };
+  auto it = std::next(b.begin());
+
+  a.splice(std::next(a.begin()), b, it);
+
+  EXPECT_EQ(TList<int>({ 1, 2, 3 }), a);
+  EXPECT_EQ(TList<int>({ 5, 6 }), b);
+  EXPECT_EQ(3u, a.size());
+  EXPECT_EQ(2u, b.size());
+  EXPECT_EQ(2, *it);
+  EXPECT_EQ(3, *++it);
+}
+
+TEST(TList, can_move_element_inside_list_with_splice)
+{
+  TList<int> l{ 1, 2, 3, 4 };
+
+  l.splice(l.begin(), l, --l.end());
+  l.splice(l.begin(), l, l.begin());
+
+  EXPECT_EQ(TList<int>({ 4, 1, 2, 3 }), l);
+  EXPECT_EQ(4u, l.size());
+}
+
+TEST(TList, can_splice_range)
+{
+  TList<int> a{ 1, 5 };
+  TList<int> b{ 0, 2, 3, 4, 6 };
+  auto first = std::next(b.begin());
+  auto last = std::next(b.begin(), 4);
+
+  a.splice(std::next(a.begin()), b, first, last);
+
+  EXPECT_EQ(TList<int>({ 1, 2, 3, 4, 5 }), a);
+  EXPECT_EQ(TList<int>({ 0, 6 }), b);
+  EXPECT_EQ(5u, a.size());
+  EXPECT_EQ(2u, b.size());
+  EXPECT_EQ(2, *first);
+  EXPECT_EQ(6, *last);
+}
+
+TEST(TList, can_splice_range_of_known_length)
+{
+  TList<int> a;
+  TList<int> b{ 1, 2, 3 };
+
+  a.splice(a.end(), b, b.begin(), std::next(b.begin(), 2), 2);
+
+  EXPECT_EQ(TList<int>({ 1, 2 }), a);
+  EXPECT_EQ(TList<int>({ 3 }), b);
+  EXPECT_EQ(1u, b.size());
+}
+
+TEST(TList, can_rotate_list_with_range_splice)
+{
+  TList<int> l{ 1, 2, 3, 4, 5 };
+
+  l.splice(l.begin(), l, std::next(l.begin(), 3), l.end());
+
+  EXPECT_EQ(TList<int>({ 4, 5, 1, 2, 3 }), l);
+  EXPECT_EQ(5u, l.size());
+}
+
+TEST(TList, splice_does_not_allocate)
+{
+  TAllocStats stats;
+  TCountingList a{ TCountingAllocator<int>(&stats) };
+  TCountingList b{ TCountingAllocator<int>(&stats) };
+  for (int i = 0; i < 5; i++)
+  {
+    a.push_back(i);
+    b.push_back(i);
+  }
+
+  a.splice(a.begin(), b, b.begin());
+  a.splice(a.end(), b, b.begin(), b.end());
+  TCountingList c = a.split_at(std::next(a.begin(), 3));
+  c.append(std::move(a));
+
+  EXPECT_EQ(10u, stats.allocs);
+  EXPECT_EQ(0u, stats.frees);
+  EXPECT_EQ(10u, c.size());
+}
+
+TEST(TList, throws_when_splice_between_different_allocators)
+{
+  TAllocStats s1, s2;
+  TCountingList a{ TCountingAllocator<int>(&s1) };
+  TCountingList b{ TCountingAllocator<int>(&s2) };
+  b.push_back(1);
+
+  ASSERT_ANY_THROW(a.splice(a.end(), b));
+  EXPECT_EQ(1u, b.size());
+}
+
+TEST(TList, can_split_list)
+{
+  TList<int> l{ 1, 2, 3, 4, 5 };
+  auto pos = std::next(l.begin(), 2);
+
+  TList<int> tail = l.split_at(pos);
+
+  EXPECT_EQ(TList<int>({ 1, 2 }), l);
+  EXPECT_EQ(TList<int>({ 3, 4, 5 }), tail);
+  EXPECT_EQ(2u, l.size());
+  EXPECT_EQ(3u, tail.size());
+  EXPECT_EQ(tail.begin(), pos);
+}
+
+TEST(TList, split_sizes_are_right_near_either_end)
+{
+  for (size_t k = 0; k <= 6; k++)
+  {
+    TList<int> l{ 0, 1, 2, 3, 4, 5 };
+
+    TList<int> tail = l.split_at(std::next(l.begin(), k));
+
+    EXPECT_EQ(k, l.size());
+    EXPECT_EQ(6 - k, tail.size());
+    EXPECT_EQ(size_t(std::distance(l.begin(), l.end())), l.size());
+    EXPECT_EQ(size_t(std::distance(tail.begin(), tail.end())), tail.size());
+  }
+}
+
+TEST(TList, can_append_list)
+{
+  TList<int> a{ 1, 2 };
+  TList<int> b{ 3, 4 };
+  auto it = b.begin();
+
+  a.append(std::move(b));
+
+  EXPECT_EQ(TList<int>({ 1, 2, 3, 4 }), a);
+  EXPECT_EQ(4u, a.size());
+  EXPECT_TRUE(b.empty());
+  EXPECT_EQ(3, *it);
+  EXPECT_EQ(4, a.back());
+}
+
+TEST(TList, can_sort_list)
+{
+  TList<int> l{ 5, 3, 9, 1, 4, 1, 0 };
+
+  l.sort();
+
+  EXPECT_EQ(TList<int>({ 0, 1, 1, 3, 4, 5, 9 }), l);
+  EXPECT_EQ(7u, l.size());
+  EXPECT_EQ(9, l.back());
+  EXPECT_EQ(9, *--l.end());
+}
+
+TEST(TList, can_sort_empty_and_single_element_lists)
+{
+  TList<int> e;
+  TList<int> one{ 1 };
+
+  e.sort();
+  one.sort();
+
+  EXPECT_TRUE(e.empty());
+  EXPECT_EQ(TList<int>({ 1 }), one);
+}
+
+TEST(TList, can_sort_with_comparator)
+{
+  TList<int> l{ 1, 3, 2 };
+
+  l.sort(std::greater<int>());
+
+  EXPECT_EQ(TList<int>({ 3, 2, 1 }), l);
+}
+
+TEST(TList, sort_matches_std_stable_sort)
+{
+  std::vector<std::pair<int, int>> ref;
+  unsigned seed = 42;
+  for (int i = 0; i < 5000; i++)
+  {
+    seed = seed * 1103515245u + 12345u;
+    ref.push_back({ int((seed >> 16) % 100), i });
+  }
+  TList<std::pair<int, int>> l(ref.begin(), ref.end());
+  auto byKey = [](const std::pair<int, int>& a, const std::pair<int, int>& b) { return a.first < b.first; };
+
+  l.sort(byKey);
+  std::stable_sort(ref.begin(), ref.end(), byKey);
+
+  EXPECT_TRUE(std::equal(ref.begin(), ref.end(), l.begin()));
+  EXPECT_TRUE(std::equal(ref.rbegin(), ref.rend(), l.rbegin()));
+}
+
+TEST(TList, sort_relinks_nodes_without_allocating)
+{
+  TAllocStats stats;
+  TCountingList l{ TCountingAllocator<int>(&stats) };
+  for (int i = 0; i < 100; i++)
+    l.push_front(i);
+  auto it = l.begin();
+
+  l.sort();
+
+  EXPECT_EQ(100u, stats.allocs);
+  EXPECT_EQ(0u, stats.frees);
+  EXPECT_EQ(99, *it);
+  EXPECT_EQ(l.end(), ++it);
+}
+
+TEST(TList, keeps_all_elements_when_comparator_throws)
+{
+  TList<int> l;
+  for (int i = 0; i < 200; i++)
+    l.push_back((i * 37) % 200);
+  int calls = 0;
+  auto comp = [&calls](int a, int b) {
+    if (++calls == 500)
+      throw std::runtime_error("comparator failed");
+    return a < b;
+  };
+
+  ASSERT_ANY_THROW(l.sort(comp));
+
+  std::vector<int> v(l.begin(), l.end());
+  std::sort(v.begin(), v.end());
+  EXPECT_EQ(200u, l.size());
+  EXPECT_EQ(200u, v.size());
+  for (int i = 0; i < 200; i++)
+    EXPECT_EQ(i, v[i]);
+  EXPECT_EQ(200, std::distance(l.rbegin(), l.rend()));
+}
+
+TEST(TList, parallel_sort_matches_std_stable_sort)
+{
+  std::vector<std::pair<int, int>> ref;
+  unsigned seed = 7;
+  for (int i = 0; i < 50000; i++)
+  {
+    seed = seed * 1103515245u + 12345u;
+    ref.push_back({ int((seed >> 16) % 1000), i });
+  }
+  auto byKey = [](const std::pair<int, int>& a, const std::pair<int, int>& b) { return a.first < b.first; };
+
+  for (size_t threads : { 1, 2, 3, 5, 8 })
+  {
+    TList<std::pair<int, int>> l(ref.begin(), ref.end());
+    std::vector<std::pair<int, int>> sorted = ref;
+
+    l.parallel_sort(byKey, threads);
+    std::stable_sort(sorted.begin(), sorted.end(), byKey);
+
+    EXPECT_EQ(ref.size(), l.size());
+    EXPECT_TRUE(std::equal(sorted.begin(), sorted.end(), l.begin()));
+    EXPECT_TRUE(std::equal(sorted.rbegin(), sorted.rend(), l.rbegin()));
+  }
+}
+
+TEST(TList, parallel_sort_relinks_nodes_without_allocating_elements)
+{
+  TAllocStats stats;
+  TCountingList l{ TCountingAllocator<int>(&stats) };
+  for (int i = 0; i < 10000; i++)
+    l.push_front(i);
+  auto it = l.begin();
+
+  l.parallel_sort(std::less<int>(), 4);
+
+  EXPECT_EQ(10000u, stats.allocs);
+  EXPECT_EQ(0u, stats.frees);
+  EXPECT_EQ(9999, *it);
+  EXPECT_EQ(l.end(), ++it);
+  EXPECT_EQ(0, l.front());
+}
+
+TEST(TList, parallel_sort_handles_short_lists)
+{
+  TList<int> empty;
+  TList<int> l{ 3, 1, 2 };
+
+  empty.parallel_sort();
+  l.parallel_sort();
+
+  EXPECT_TRUE(empty.empty());
+  EXPECT_EQ(TList<int>({ 1, 2, 3 }), l);
+}
+
+TEST(TList, parallel_sort_keeps_all_elements_when_comparator_throws)
+{
+  TList<int> l;
+  for (int i = 0; i < 8000; i++)
+    l.push_back((i * 37) % 8000);
+  auto comp = [](int a, int b) {
+    if (a == 4321)
+      throw std::runtime_error("comparator failed");
+    return a < b;
+  };
+
+  ASSERT_ANY_THROW(l.parallel_sort(comp, 4));
+
+  std::vector<int> v(l.begin(), l.end());
+  std::sort(v.begin(), v.end());
+  EXPECT_EQ(8000u, l.size());
+  ASSERT_EQ(8000u, v.size());
+  for (int i = 0; i < 8000; i++)
+    EXPECT_EQ(i, v[i]);
+  EXPECT_EQ(8000, std::distance(l.rbegin(), l.rend()));
+}
+
+TEST(TList, can_radix_sort_negative_ints)
+{
+  TList<int> l{ 3, -1, 0, -100, 42, INT_MIN, INT_MAX, -1 };
+
+  l.radix_sort([](int x) { return x; });
+
+  EXPECT_EQ(TList<int>({ INT_MIN, -100, -1, -1, 0, 3, 42, INT_MAX }), l);
+  EXPECT_EQ(INT_MAX, *l.rbegin());
+}
+
+TEST(TList, can_radix_sort_unsigned_64_bit_keys)
+{
+  TList<uint64_t> l{ 5, ~0ull, 0, 1ull << 40, 7 };
+
+  l.radix_sort([](uint64_t x) { return x; });
+
+  EXPECT_EQ(TList<uint64_t>({ 0, 5, 7, 1ull << 40, ~0ull }), l);
+}
+
+TEST(TList, radix_sort_puts_nans_after_infinity)
+{
+  const double inf = std::numeric_limits<double>::infinity();
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  TList<double> l{ 2.5, nan, -inf, -0.5, inf, -nan, 0.0, -3.0 };
+
+  l.radix_sort([](double x) { return x; });
+
+  std::vector<double> v(l.begin(), l.end());
+  ASSERT_EQ(8u, v.size());
+  EXPECT_EQ(-inf, v[0]);
+  EXPECT_EQ(-3.0, v[1]);
+  EXPECT_EQ(-0.5, v[2]);
+  EXPECT_EQ(0.0, v[3]);
+  EXPECT_EQ(2.5, v[4]);
+  EXPECT_EQ(inf, v[5]);
+  EXPECT_TRUE(std::isnan(v[6]));
+  EXPECT_TRUE(std::isnan(v[7]));
+}
+
+TEST(TList, radix_sort_orders_floats)
+{
+  TList<float> l{ 1.5f, -2.25f, 0.0f, -0.0f, 1e30f, -1e-30f };
+
+  l.radix_sort([](float x) { return x; });
+
+  EXPECT_TRUE(std::is_sorted(l.begin(), l.end()));
+}
+
+TEST(TList, radix_sort_is_stable)
+{
+  std::vector<std::pair<short, int>> ref;
+  unsigned seed = 9;
+  for (int i = 0; i < 3000; i++)
+  {
+    seed = seed * 1103515245u + 12345u;
+    ref.push_back({ short(int((seed >> 16) % 2000) - 1000), i });
+  }
+  TList<std::pair<short, int>> l(ref.begin(), ref.end());
+  auto key = [](const std::pair<short, int>& p) { return p.first; };
+
+  l.radix_sort(key);
+  std::stable_sort(ref.begin(), ref.end(),
+                   [](const std::pair<short, int>& a, const std::pair<short, int>& b) { return a.first < b.first; });
+
+  EXPECT_TRUE(std::equal(ref.begin(), ref.end(), l.begin()));
+  EXPECT_TRUE(std::equal(ref.rbegin(), ref.rend(), l.rbegin()));
+}
+
+TEST(TList, radix_sort_keeps_node_identity)
+{
+  TList<int> l{ 3, 1, 2 };
+  const int* one = &*std::next(l.begin());
+
+  l.radix_sort([](int x) { return x; });
+
+  EXPECT_EQ(one, &l.front());
+}
+
+TEST(TList, keeps_all_elements_when_radix_key_throws)
+{
+  TList<int> l;
+  for (int i = 0; i < 100; i++)
+    l.push_back(100 - i);
+  int calls = 0;
+  auto key = [&calls](int x) {
+    if (++calls == 150)
+      throw std::runtime_error("key failed");
+    return x;
+  };
+
+  ASSERT_ANY_THROW(l.radix_sort(key));
+
+  std::vector<int> v(l.begin(), l.end());
+  std::sort(v.begin(), v.end());
+  ASSERT_EQ(100u, v.size());
+  for (int i = 0; i < 100; i++)
+    EXPECT_EQ(i + 1, v[i]);
+  EXPECT_EQ(100, std::distance(l.rbegin(), l.rend()));
+}
+
+TEST(TList, can_merge_sorted_lists)
+{
+  TList<int> a{ 1, 4, 6 };
+  TList<int> b{ 2, 3, 5, 7 };
+
+  a.merge(b);
+
+  EXPECT_EQ(TList<int>({ 1, 2, 3, 4, 5, 6, 7 }), a);
+  EXPECT_EQ(7u, a.size());
+  EXPECT_TRUE(b.empty());
+  EXPECT_EQ(b.begin(), b.end());
+  EXPECT_EQ(7, *a.rbegin());
+}
+
+TEST(TList, can_merge_into_empty_list)
+{
+  TList<int> a;
+  TList<int> b{ 1, 2 };
+
+  a.merge(std::move(b));
+
+  EXPECT_EQ(TList<int>({ 1, 2 }), a);
+  EXPECT_TRUE(b.empty());
+}
+
+TEST(TList, merge_with_itself_does_nothing)
+{
+  TList<int> a{ 1, 2 };
+
+  a.merge(a);
+
+  EXPECT_EQ(TList<int>({ 1, 2 }), a);
+}
+
+TEST(TList, merge_prefers_elements_of_this_list_on_ties)
+{
+  using TItem = std::pair<int, char>;
+  TList<TItem> a{ { 1, 'a' }, { 2, 'a' } };
+  TList<TItem> b{ { 1, 'b' }, { 2, 'b' } };
+
+  a.merge(b, [](const TItem& x, const TItem& y) { return x.first < y.first; });
+
+  EXPECT_EQ(TList<TItem>({ { 1, 'a' }, { 1, 'b' }, { 2, 'a' }, { 2, 'b' } }), a);
+}
+
+TEST(TList, merge_relinks_without_allocating)
+{
+  TAllocStats stats;
+  TCountingList a{ TCountingAllocator<int>(&stats) };
+  TCountingList b{ TCountingAllocator<int>(&stats) };
+  for (int i = 0; i < 10; i++)
+    (i % 2 ? a : b).push_back(i);
+  auto it = b.begin();
+
+  a.merge(b);
+
+  EXPECT_EQ(10u, stats.allocs);
+  EXPECT_EQ(0u, stats.frees);
+  EXPECT_EQ(0, *it);
+  EXPECT_EQ(1, *++it);
+}
+
+TEST(TList, can_merge_many_shards)
+{
+  std::vector<TList<int>> shards(7);
+  std::vector<int> all;
+  for (int i = 0; i < 500; i++)
+  {
+    int v = (i * 7919) % 311;
+    shards[i % 7].push_back(v);
+    all.push_back(v);
+  }
+  for (auto& s : shards)
+    s.sort();
+  std::sort(all.begin(), all.end());
+
+  TList<int> merged = tlist::merge_k(shards.begin(), shards.end());
+
+  EXPECT_EQ(500u, merged.size());
+  EXPECT_TRUE(std::equal(all.begin(), all.end(), merged.begin()));
+  EXPECT_TRUE(std::equal(all.rbegin(), all.rend(), merged.rbegin()));
+  for (auto& s : shards)
+    EXPECT_TRUE(s.empty());
+}
+
+TEST(TList, merge_of_many_shards_is_stable)
+{
+  using TItem = std::pair<int, int>;
+  std::vector<TList<TItem>> shards(4);
+  for (int s = 0; s < 4; s++)
+    for (int k = 0; k < 3; k++)
+      shards[s].push_back({ k, s });
+
+  TList<TItem> merged = tlist::merge_k(shards.begin(), shards.end(),
+                                       [](const TItem& x, const TItem& y) { return x.first < y.first; });
+
+  std::vector<TItem> v(merged.begin(), merged.end());
+  ASSERT_EQ(12u, v.size());
+  for (int i = 0; i < 12; i++)
+    EXPECT_EQ(TItem(i / 4, i % 4), v[i]);
+}
+
+TEST(TList, merge_of_no_shards_is_empty)
+{
+  std::vector<TList<int>> shards;
+  std::vector<TList<int>> empties(3);
+
+  EXPECT_TRUE(tlist::merge_k(shards.begin(), shards.end()).empty());
+  EXPECT_TRUE(tlist::merge_k(empties.begin(), empties.end()).empty());
+}
+
+TEST(TList, merge_of_two_shards_uses_pairwise_merge)
+{
+  std::vector<TList<int>> shards{ TList<int>{ 1, 3 }, TList<int>{ 2, 4 } };
+
+  TList<int> merged = tlist::merge_k(shards.begin(), shards.end());
+
+  EXPECT_EQ(TList<int>({ 1, 2, 3, 4 }), merged);
+}
+
+TEST(TList, can_insert_and_erase_by_position)
+{
+  TList<int> l{ 1, 3 };
+
+  l.insert_at(1, 2);
+  l.insert_at(3, 4);
+  l.insert_at(0, 0);
+  auto it = l.erase_at(2);
+
+  EXPECT_EQ(3, *it);
+  EXPECT_EQ(TList<int>({ 0, 1, 3, 4 }), l);
+  ASSERT_ANY_THROW(l.insert_at(5, 9));
+  ASSERT_ANY_THROW(l.erase_at(4));
+}
+
+TEST(TList, sequential_and_const_indexing_read_right_values)
+{
+  const int n = 10000;
+  TList<int> l;
+  for (int i = 0; i < n; i++)
+    l.push_back(i);
+  const TList<int>& cl = l;
+
+  for (int i = 0; i < n; i++)
+    ASSERT_EQ(i, l[i]);
+  for (int i = n; i-- > 0;)
+    ASSERT_EQ(i, l.at(i));
+  // Const reads start from the cursor without moving it; the non-const
+  // read after each one still finds its element.
+  for (int i = n / 2; i < n / 2 + 1000; i++)
+  {
+    ASSERT_EQ(i, cl[i]);
+    ASSERT_EQ(i - 1000, cl.at(i - 1000));
+    ASSERT_EQ(i, l[i]);
+  }
+}
+
+TEST(TList, positional_reads_stay_correct_across_edits)
+{
+  TList<int> l;
+  std::vector<int> ref;
+  unsigned seed = 2024;
+  auto rnd = [&seed]() { seed = seed * 1103515245u + 12345u; return (seed >> 16) & 0x7fff; };
+
+  for (int step = 0; step < 4000; step++)
+  {
+    // Park the cursor somewhere, then edit around it.
+    if (!ref.empty())
+    {
+      size_t probe = rnd() % ref.size();
+      ASSERT_EQ(ref[probe], l[probe]);
+    }
+    switch (ref.empty() ? 0 : rnd() % 8)
+    {
+    case 0:
+      l.push_front(step);
+      ref.insert(ref.begin(), step);
+      break;
+    case 1:
+      l.push_back(step);
+      ref.push_back(step);
+      break;
+    case 2:
+      l.pop_front();
+      ref.erase(ref.begin());
+      break;
+    case 3:
+      l.pop_back();
+      ref.pop_back();
+      break;
+    case 4:
+    {
+      size_t pos = rnd() % (ref.size() + 1);
+      l.insert_at(pos, step);
+      ref.insert(ref.begin() + pos, step);
+      break;
+    }
+    case 5:
+    {
+      size_t pos = rnd() % ref.size();
+      l.erase_at(pos);
+      ref.erase(ref.begin() + pos);
+      break;
+    }
+    case 6:
+    {
+      size_t pos = rnd() % ref.size();
+      l.insert(std::next(l.begin(), pos), step);
+      ref.insert(ref.begin() + pos, step);
+      break;
+    }
+    default:
+    {
+      size_t pos = rnd() % ref.size();
+      l.erase(std::next(l.begin(), pos));
+      ref.erase(ref.begin() + pos);
+      break;
+    }
+    }
+    if (!ref.empty())
+    {
+      size_t probe = rnd() % ref.size();
+      ASSERT_EQ(ref[probe], l.at(probe));
+    }
+  }
+
+  ExpectSameSequence(ref, l);
+}
+
+TEST(TList, positional_reads_survive_bulk_changes)
+{
+  TList<int> l{ 5, 4, 3, 2, 1 };
+  EXPECT_EQ(2, l[3]);
+
+  l.sort();
+  EXPECT_EQ(4, l[3]);
+
+  TList<int> other{ 0 };
+  l.splice(l.begin(), other);
+  EXPECT_EQ(3, l[3]);
+
+  l.clear();
+  l.push_back(9);
+  EXPECT_EQ(9, l[0]);
+
+  TList<int> moved = std::move(l);
+  EXPECT_EQ(9, moved.at(0));
+  EXPECT_THROW(l.at(0), std::out_of_range);
+}
+
+TEST(TList, plain_list_carries_no_index)
+{
+  // The skip index is an empty base unless the list is ranked.
+  EXPECT_LT(sizeof(TList<int>), sizeof(TRankedList<int>));
+}
+
+TEST(TRankedList, matches_reference_under_random_positional_edits)
+{
+  TRankedList<int> l;
+  std::vector<int> ref;
+  unsigned seed = 99;
+  auto rnd = [&seed]() { seed = seed * 1103515245u + 12345u; return (seed >> 16) & 0x7fff; };
+
+  for (int step = 0; step < 5000; step++)
+  {
+    unsigned op = rnd() % 8;
+    if (ref.empty() || op < 3)
+    {
+      size_t pos = rnd() % (ref.size() + 1);
+      l.insert_at(pos, step);
+      ref.insert(ref.begin() + pos, step);
+    }
+    else if (op < 5)
+    {
+      size_t pos = rnd() % ref.size();
+      l.erase_at(pos);
+      ref.erase(ref.begin() + pos);
+    }
+    else if (op == 5)
+    {
+      l.push_front(step);
+      ref.insert(ref.begin(), step);
+    }
+    else if (op == 6)
+    {
+      l.pop_back();
+      ref.pop_back();
+    }
+    size_t probe = ref.empty() ? 0 : rnd() % ref.size();
+    if (!ref.empty())
+    {
+      ASSERT_EQ(ref[probe], l.at(probe));
+    }
+  }
+
+  ExpectSameSequence(ref, l);
+  for (size_t i = 0; i < ref.size(); i++)
+    EXPECT_EQ(ref[i], l[i]);
+}
+
+TEST(TRankedList, index_follows_structural_changes)
+{
+  TRankedList<int> l;
+  for (int i = 0; i < 1000; i++)
+    l.push_back(999 - i);
+  EXPECT_EQ(500, l[499]);
+
+  l.sort();
+  EXPECT_EQ(499, l[499]);
+
+  l.insert(std::next(l.begin(), 10), -1);
+  EXPECT_EQ(-1, l[10]);
+  EXPECT_EQ(10, l[11]);
+
+  TRankedList<int> tail = l.split_at(std::next(l.begin(), 600));
+  EXPECT_EQ(598, l.at(599));
+  EXPECT_EQ(600, tail.at(1));
+
+  l.swap(tail);
+  EXPECT_EQ(600, l[1]);
+  EXPECT_EQ(9, tail[9]);
+
+  l.splice(l.begin(), tail);
+  EXPECT_EQ(999, l.back());
+  EXPECT_EQ(999, l.at(l.size() - 1));
+  ASSERT_THROW(l.at(l.size()), std::out_of_range);
+}
+
+TEST(TRankedList, iterator_edits_keep_the_index_current)
+{
+  TAllocStats stats;
+  TRankedList<int, TCountingAllocator<int>> l{ TCountingAllocator<int>(&stats) };
+  std::vector<int> ref;
+  for (int i = 0; i < 2000; i++)
+  {
+    l.push_back(i);
+    ref.push_back(i);
+  }
+  EXPECT_EQ(1000, l[1000]);
+  size_t allocs = stats.allocs;
+  unsigned seed = 5;
+  auto rnd = [&seed]() { seed = seed * 1103515245u + 12345u; return (seed >> 16) & 0x7fff; };
+
+  for (int step = 0; step < 300; step++)
+  {
+    size_t pos = rnd() % ref.size();
+    auto it = std::next(l.begin(), pos);
+    switch (rnd() % 3)
+    {
+    case 0:
+      l.insert(it, -step);
+      ref.insert(ref.begin() + pos, -step);
+      break;
+    case 1:
+      l.erase(it);
+      ref.erase(ref.begin() + pos);
+      break;
+    default:
+    {
+      size_t to = rnd() % ref.size();
+      l.splice(std::next(l.begin(), to), l, it);
+      int v = ref[pos];
+      ref.erase(ref.begin() + pos);
+      ref.insert(ref.begin() + (to > pos ? to - 1 : to), v);
+      break;
+    }
+    }
+    size_t probe = rnd() % ref.size();
+    const auto& cl = l;
+    ASSERT_EQ(ref[probe], cl[probe]);
+    ASSERT_EQ(ref[probe], l.at(probe));
+  }
+
+  // A rebuild would reallocate about one tower per four nodes; updating in
+  // place allocates at most a node and a tower per edit.
+  EXPECT_GT(allocs + 3 * 300, stats.allocs);
+  ExpectSameSequence(ref, l);
+}
+
+TEST(TRankedList, frees_its_towers)
+{
+  TAllocStats stats;
+  {
+    TRankedList<int, TCountingAllocator<int>> l{ TCountingAllocator<int>(&stats) };
+    for (int i = 0; i < 500; i++)
+      l.insert_at(l.size() / 2, i);
+    for (int i = 0; i < 100; i++)
+      l.erase_at(i);
+    EXPECT_LT(400u, stats.live);
+    l.sort();
+    EXPECT_LT(l[0], l.at(200));
+  }
+
+  EXPECT_EQ(stats.allocs, stats.frees);
+  EXPECT_EQ(0u, stats.live);
+}
+
+TEST(TRankedList, copies_and_moves_like_a_list)
+{
+  TRankedList<std::string> a{ "x", "y", "z" };
+
+  TRankedList<std::string> b = a;
+  TRankedList<std::string> c = std::move(a);
+  b.insert_at(1, "w");
+
+  EXPECT_EQ("w", b[1]);
+  EXPECT_EQ("z", c.at(2));
+  EXPECT_TRUE(a.empty());
+}
+
+TEST(TIndexedList, keeps_insertion_order_and_drops_duplicates)
+{
+  TIndexedList<int> l{ 5, 3, 5, 1, 3 };
+
+  auto r = l.push_back(3);
+  l.push_front(9);
+
+  EXPECT_FALSE(r.second);
+  EXPECT_EQ(3, *r.first);
+  EXPECT_EQ(std::vector<int>({ 9, 5, 3, 1 }), std::vector<int>(l.begin(), l.end()));
+  EXPECT_EQ(4u, l.size());
+}
+
+TEST(TIndexedList, can_find_and_erase_by_value)
+{
+  TIndexedList<std::string> l;
+  for (int i = 0; i < 1000; i++)
+    l.push_back(std::to_string(i));
+
+  EXPECT_TRUE(l.contains("417"));
+  EXPECT_EQ("418", *std::next(l.find("417")));
+  EXPECT_EQ(l.end(), l.find("1000"));
+
+  EXPECT_EQ(1u, l.erase("417"));
+  EXPECT_EQ(0u, l.erase("417"));
+  EXPECT_FALSE(l.contains("417"));
+  EXPECT_EQ("418", *std::next(l.find("416")));
+  EXPECT_EQ(999u, l.size());
+}
+
+namespace
+{
+  // Sends every key to one of a handful of buckets so lookups walk long
+  // probe runs and erase has to shift them.
+  struct TClumpHash
+  {
+    size_t operator()(int x) const { return size_t(x % 4); }
+  };
+}
+
+TEST(TIndexedList, lookups_survive_collisions_and_erases)
+{
+  TIndexedList<int, TClumpHash> l;
+  for (int i = 0; i < 300; i++)
+    l.push_back(i);
+
+  for (int i = 0; i < 300; i += 3)
+    l.erase(i);
+  l.pop_front();
+  l.erase(l.find(299));
+
+  for (int i = 0; i < 300; i++)
+    EXPECT_EQ(i % 3 != 0 && i != 1 && i != 299, l.contains(i)) << i;
+  EXPECT_EQ(198u, l.size());
+}
+
+TEST(TIndexedList, copies_carry_their_own_index)
+{
+  TIndexedList<int> a{ 1, 2, 3 };
+
+  TIndexedList<int> b = a;
+  a.erase(2);
+  b.push_back(4);
+  TIndexedList<int> c = std::move(b);
+
+  EXPECT_TRUE(c.contains(2));
+  EXPECT_FALSE(a.contains(2));
+  EXPECT_FALSE(a.contains(4));
+  EXPECT_EQ(TIndexedList<int>({ 1, 2, 3, 4 }), c);
+
+  a = c;
+  c.clear();
+  EXPECT_TRUE(a.contains(4));
+  EXPECT_FALSE(c.contains(4));
+  EXPECT_TRUE(c.push_back(4).second);
+}
+
+namespace
+{
+  // Treats keys as equal modulo m; a default-constructed one has no m.
+  struct TModHash
+  {
+    int m = 0;
+    size_t operator()(int x) const { return size_t(x % m); }
+  };
+
+  struct TModEqual
+  {
+    int m = 0;
+    bool operator()(int a, int b) const { return a % m == b % m; }
+  };
+}
+
+TEST(TIndexedList, copies_keep_hash_and_equality)
+{
+  using TModList = TIndexedList<int, TModHash, TModEqual>;
+  TModList a(std::allocator<int>(), TModHash{ 10 }, TModEqual{ 10 });
+  a.push_back(1);
+  a.push_back(12);
+
+  TModList b = a;
+  TModList c(std::allocator<int>(), TModHash{ 3 }, TModEqual{ 3 });
+  c = b;
+
+  EXPECT_EQ(10, b.hash_function().m);
+  EXPECT_EQ(10, b.key_eq().m);
+  EXPECT_TRUE(b.contains(22));
+  EXPECT_FALSE(b.push_back(11).second);
+  EXPECT_TRUE(c.contains(21));
+}
+
+TEST(TIndexedList, releases_nodes_and_table)
+{
+  TAllocStats stats;
+  {
+    TIndexedList<int, std::hash<int>, std::equal_to<int>, TCountingAllocator<int>> l{ TCountingAllocator<int>(&stats) };
+    for (int i = 0; i < 200; i++)
+      l.push_back(i);
+    for (int i = 0; i < 200; i += 2)
+      l.erase(i);
+  }
+
+  EXPECT_EQ(stats.allocs, stats.frees);
+  EXPECT_EQ(0u, stats.live);
+}
+
+namespace
+{
+  // A connection that sits in one state list and, independently, in the
+  // list of connections owned by its worker.
+  struct TConnection
+  {
+    int id;
+    TListHook stateHook;
+    TListHook workerHook;
+
+    explicit TConnection(int i) : id(i) {}
+  };
+
+  using TStateList = TIntrusiveList<TConnection, &TConnection::stateHook>;
+  using TWorkerList = TIntrusiveList<TConnection, &TConnection::workerHook>;
+
+  template <class L>
+  std::vector<int> Ids(const L& l)
+  {
+    std::vector<int> ids;
+    for (const TConnection& c : l)
+      ids.push_back(c.id);
+    return ids;
+  }
+}
+
+TEST(TIntrusiveList, links_objects_in_place)
+{
+  TConnection a(1), b(2), c(3);
+  TStateList l;
+
+  l.push_back(b);
+  l.push_front(a);
+  l.push_back(c);
+
+  EXPECT_EQ(std::vector<int>({ 1, 2, 3 }), Ids(l));
+  EXPECT_EQ(&b, &*std::next(l.begin()));
+  EXPECT_EQ(3, l.rbegin()->id);
+  EXPECT_TRUE(b.stateHook.is_linked());
+  EXPECT_FALSE(b.workerHook.is_linked());
+}
+
+TEST(TIntrusiveList, can_unlink_object_from_anywhere)
+{
+  TConnection a(1), b(2), c(3);
+  TStateList l;
+  l.push_back(a);
+  l.push_back(b);
+  l.push_back(c);
+
+  l.erase(b);
+
+  EXPECT_FALSE(b.stateHook.is_linked());
+  EXPECT_EQ(std::vector<int>({ 1, 3 }), Ids(l));
+  EXPECT_EQ(2u, l.size());
+}
+
+TEST(TIntrusiveList, object_can_sit_in_several_lists)
+{
+  TConnection a(1), b(2);
+  TStateList idle;
+  TWorkerList worker;
+
+  idle.push_back(a);
+  idle.push_back(b);
+  worker.push_back(b);
+  worker.push_back(a);
+
+  idle.erase(a);
+
+  EXPECT_EQ(std::vector<int>({ 2 }), Ids(idle));
+  EXPECT_EQ(std::vector<int>({ 2, 1 }), Ids(worker));
+}
+
+TEST(TIntrusiveList, can_move_objects_between_lists)
+{
+  std::vector<TConnection> conns;
+  for (int i = 0; i < 6; i++)
+    conns.emplace_back(i);
+  TStateList idle, active, closing;
+  for (TConnection& c : conns)
+    idle.push_back(c);
+
+  active.splice(active.end(), idle, conns[2]);
+  active.splice(active.end(), idle, conns[4]);
+  closing.splice(closing.begin(), active, conns[2]);
+
+  EXPECT_EQ(std::vector<int>({ 0, 1, 3, 5 }), Ids(idle));
+  EXPECT_EQ(std::vector<int>({ 4 }), Ids(active));
+  EXPECT_EQ(std::vector<int>({ 2 }), Ids(closing));
+  EXPECT_EQ(4u, idle.size());
+  EXPECT_EQ(1u, active.size());
+
+  idle.splice(idle.begin(), closing);
+  EXPECT_EQ(std::vector<int>({ 2, 0, 1, 3, 5 }), Ids(idle));
+  EXPECT_TRUE(closing.empty());
+}
+
+TEST(TIntrusiveList, rejects_object_already_linked)
+{
+  TConnection a(1);
+  TStateList l1, l2;
+  l1.push_back(a);
+
+  ASSERT_THROW(l2.push_back(a), std::invalid_argument);
+  ASSERT_THROW(l1.push_back(a), std::invalid_argument);
+  EXPECT_EQ(1u, l1.size());
+  EXPECT_TRUE(l2.empty());
+}
+
+TEST(TIntrusiveList, clearing_unlinks_but_keeps_objects)
+{
+  TConnection a(1), b(2);
+  {
+    TStateList l;
+    l.push_back(a);
+    l.push_back(b);
+  }
+
+  EXPECT_FALSE(a.stateHook.is_linked());
+
+  TStateList l;
+  l.push_back(a);
+  l.push_back(b);
+  EXPECT_EQ(1u, l.remove_if([](const TConnection& c) { return c.id == 1; }));
+  l.clear();
+  EXPECT_FALSE(b.stateHook.is_linked());
+  ASSERT_THROW(l.front(), std::out_of_range);
+}
+
+TEST(TIntrusiveList, copied_object_starts_unlinked)
+{
+  TConnection a(1);
+  TStateList l;
+  l.push_back(a);
+
+  TConnection b = a;
+
+  EXPECT_FALSE(b.stateHook.is_linked());
+  l.push_back(b);
+  EXPECT_EQ(2u, l.size());
+  l.clear();
+}
+
+TEST(TIntrusiveList, can_move_and_swap_lists)
+{
+  TConnection a(1), b(2), c(3);
+  TStateList l1;
+  l1.push_back(a);
+  l1.push_back(b);
+
+  TStateList l2 = std::move(l1);
+  TStateList l3;
+  l3.push_back(c);
+  l2.swap(l3);
+
+  EXPECT_TRUE(l1.empty());
+  EXPECT_EQ(std::vector<int>({ 3 }), Ids(l2));
+  EXPECT_EQ(std::vector<int>({ 1, 2 }), Ids(l3));
+  EXPECT_EQ(&a, &*l3.iterator_to(a));
+  l3.pop_front();
+  EXPECT_EQ(2, l3.front().id);
+  EXPECT_EQ(2, l3.back().id);
+}
+
+namespace
+{
+  using TCountingSmallList = TSmallList<int, 4, TCountingAllocator<int>>;
+}
+
+TEST(TSmallList, short_list_does_not_allocate)
+{
+  TAllocStats stats;
+  {
+    TCountingSmallList l{ TCountingAllocator<int>(&stats) };
+    for (int i = 0; i < 4; i++)
+      l.push_back(i);
+    l.pop_front();
+    l.push_front(7);
+    l.sort();
+
+    EXPECT_EQ(TList<int>({ 1, 2, 3, 7 }), TList<int>(l.begin(), l.end()));
+  }
+
+  EXPECT_EQ(0u, stats.allocs);
+}
+
+TEST(TSmallList, spills_to_allocator_past_inline_capacity)
+{
+  TAllocStats stats;
+  {
+    TCountingSmallList l{ TCountingAllocator<int>(&stats) };
+    for (int i = 0; i < 10; i++)
+      l.push_back(i);
+
+    EXPECT_EQ(6u, stats.allocs);
+
+    // Freed inline slots are reused before the heap is asked again.
+    l.pop_front();
+    l.pop_front();
+    l.push_back(10);
+    l.push_back(11);
+    EXPECT_EQ(6u, stats.allocs);
+    EXPECT_EQ(10u, l.size());
+    EXPECT_EQ(11, l.back());
+  }
+
+  EXPECT_EQ(stats.allocs, stats.frees);
+}
+
+TEST(TSmallList, copies_and_moves_between_own_storage)
+{
+  TSmallList<std::string, 2> a{ "a", "b", "c" };
+
+  TSmallList<std::string, 2> b = a;
+  TSmallList<std::string, 2> c = std::move(b);
+  b = { "x" };
+  a = c;
+  c.push_back("d");
+
+  EXPECT_EQ(3u, a.size());
+  EXPECT_EQ("c", a.back());
+  EXPECT_EQ("x", b.front());
+  EXPECT_EQ(4u, c.size());
+}
+
+TEST(TSmallList, swap_exchanges_elements)
+{
+  TSmallList<int, 2> a{ 1, 2, 3 };
+  TSmallList<int, 2> b{ 4 };
+
+  swap(a, b);
+  a.push_back(5);
+
+  EXPECT_EQ(TList<int>({ 4, 5 }), TList<int>(a.begin(), a.end()));
+  EXPECT_EQ(TList<int>({ 1, 2, 3 }), TList<int>(b.begin(), b.end()));
+}
+
+TEST(TSmallList, cannot_splice_between_two_small_lists)
+{
+  TSmallList<int, 2> a{ 1, 2 };
+  TSmallList<int, 2> b{ 3 };
+
+  ASSERT_THROW(a.splice(a.end(), b), std::invalid_argument);
+
+  a.splice(a.begin(), a, std::prev(a.end()));
+  EXPECT_EQ(2, a.front());
+}
+
+TEST(TSmallList, copies_and_moves_keep_upstream_allocator)
+{
+  TAllocStats stats;
+  {
+    TCountingSmallList a{ TCountingAllocator<int>(&stats) };
+    for (int i = 0; i < 6; i++)
+      a.push_back(i);
+
+    TCountingSmallList b = a;
+    TCountingSmallList c = std::move(a);
+
+    EXPECT_EQ(6u, stats.allocs);
+    EXPECT_TRUE(b.get_allocator().upstream_allocator() == TCountingAllocator<int>(&stats));
+    EXPECT_TRUE(c.get_allocator().upstream_allocator() == TCountingAllocator<int>(&stats));
+  }
+
+  EXPECT_EQ(stats.allocs, stats.frees);
+}
+
+TEST(TSmallList, split_at_returns_list_with_own_storage)
+{
+  auto l = std::make_unique<TSmallList<std::string, 2>>(
+    std::initializer_list<std::string>{ "a", "b", "c", "d", "e" });
+
+  TSmallList<std::string, 2> tail = l->split_at(std::next(l->begin(), 2));
+  EXPECT_EQ(2u, l->size());
+  EXPECT_EQ("b", l->back());
+  l.reset();
+  tail.push_front("x");
+  tail.pop_back();
+
+  EXPECT_EQ((std::vector<std::string>{ "x", "c", "d" }), std::vector<std::string>(tail.begin(), tail.end()));
+}
+
+namespace
+{
+  using TStaticStrings = TStaticList<std::string, 4>;
+}
+
+TEST(TStaticList, holds_up_to_capacity)
+{
+  TStaticList<int, 3> l{ 1, 2 };
+
+  l.push_front(0);
+
+  EXPECT_TRUE(l.full());
+  ASSERT_THROW(l.push_back(3), std::length_error);
+  EXPECT_EQ(std::vector<int>({ 0, 1, 2 }), std::vector<int>(l.begin(), l.end()));
+  ASSERT_THROW((TStaticList<int, 2>{ 1, 2, 3 }), std::length_error);
+}
+
+TEST(TStaticList, reuses_freed_slots)
+{
+  TStaticList<std::string, 4> l{ "a", "b", "c", "d" };
+
+  for (int i = 0; i < 100; i++)
+  {
+    l.pop_front();
+    l.push_back(std::to_string(i));
+  }
+
+  EXPECT_EQ(4u, l.size());
+  EXPECT_EQ("96", l.front());
+  EXPECT_EQ("99", l.back());
+}
+
+TEST(TStaticList, element_addresses_are_stable)
+{
+  TStaticList<int, 8> l{ 1, 2, 3 };
+  int* p = &*std::next(l.begin());
+
+  l.push_front(0);
+  l.erase(l.begin());
+  l.insert(l.begin(), 7);
+  l.pop_back();
+
+  EXPECT_EQ(2, *p);
+  EXPECT_EQ(p, &*std::next(l.begin(), 2));
+}
+
+TEST(TStaticList, copies_moves_and_swaps)
+{
+  TStaticList<std::string, 4> a{ "x", "y" };
+
+  TStaticList<std::string, 4> b = a;
+  TStaticList<std::string, 4> c = std::move(b);
+  b = { "p", "q", "r" };
+  a = b;
+  swap(a, c);
+  a.push_back("z");
+
+  EXPECT_EQ(TStaticStrings({ "x", "y", "z" }), a);
+  EXPECT_EQ(TStaticStrings({ "p", "q", "r" }), c);
+  EXPECT_EQ(3u, b.size());
+}
+
+TEST(TStaticList, empty_list_throws_on_access)
+{
+  TStaticList<int, 2> l;
+
+  ASSERT_THROW(l.front(), std::out_of_range);
+  ASSERT_THROW(l.pop_back(), std::out_of_range);
+  EXPECT_EQ(2u, l.capacity());
+}
+
+TEST(TXorList, walks_both_ways)
+{
+  TXorList<int> l{ 1, 2, 3 };
+  l.push_front(0);
+  l.push_back(4);
+
+  EXPECT_EQ(std::vector<int>({ 0, 1, 2, 3, 4 }), std::vector<int>(l.begin(), l.end()));
+  EXPECT_EQ(std::vector<int>({ 4, 3, 2, 1, 0 }), std::vector<int>(l.rbegin(), l.rend()));
+  EXPECT_EQ(0, l.front());
+  EXPECT_EQ(4, l.back());
+  EXPECT_EQ(3, *std::prev(l.end(), 2));
+}
+
+TEST(TXorList, can_insert_and_erase_in_the_middle)
+{
+  TXorList<int> l{ 1, 4 };
+  auto it = std::next(l.begin());
+
+  it = l.insert(it, 3);
+  it = l.insert(it, 2);
+  EXPECT_EQ(4, *std::next(it, 2));
+
+  it = l.erase(std::next(it));
+  EXPECT_EQ(4, *it);
+  l.erase(l.begin(), it);
+
+  EXPECT_EQ(std::vector<int>({ 4 }), std::vector<int>(l.begin(), l.end()));
+  EXPECT_EQ(1u, l.size());
+}
+
+TEST(TXorList, can_pop_to_empty_and_reuse)
+{
+  TXorList<std::string> l{ "a", "b" };
+
+  l.pop_back();
+  l.pop_front();
+  EXPECT_TRUE(l.empty());
+  EXPECT_EQ(l.begin(), l.end());
+  ASSERT_THROW(l.front(), std::out_of_range);
+
+  l.push_back("c");
+  EXPECT_EQ("c", l.front());
+  EXPECT_EQ("c", l.back());
+}
+
+TEST(TXorList, reverse_is_constant_time_flip)
+{
+  TXorList<int> l{ 1, 2, 3, 4 };
+
+  l.reverse();
+  l.push_back(0);
+
+  EXPECT_EQ(TXorList<int>({ 4, 3, 2, 1, 0 }), l);
+  EXPECT_EQ(std::vector<int>({ 0, 1, 2, 3, 4 }), std::vector<int>(l.rbegin(), l.rend()));
+}
+
+TEST(TXorList, copies_moves_and_swaps)
+{
+  TXorList<int> a{ 1, 2, 3 };
+  TXorList<int> one{ 7 };
+
+  TXorList<int> b = a;
+  TXorList<int> c = std::move(a);
+  TXorList<int> d = std::move(one);
+  b.push_back(4);
+  swap(b, d);
+  c = d;
+
+  EXPECT_TRUE(a.empty());
+  EXPECT_EQ(TXorList<int>({ 7 }), b);
+  EXPECT_EQ(7, b.back());
+  EXPECT_EQ(TXorList<int>({ 1, 2, 3, 4 }), c);
+  EXPECT_EQ(4, *c.rbegin());
+  EXPECT_EQ(1, *d.begin());
+}
+
+TEST(TXorList, move_to_other_resource_moves_elements)
+{
+  char buf1[1024], buf2[1024];
+  std::pmr::monotonic_buffer_resource a1(buf1, sizeof(buf1), std::pmr::null_memory_resource());
+  std::pmr::monotonic_buffer_resource a2(buf2, sizeof(buf2), std::pmr::null_memory_resource());
+  TXorList<int, std::pmr::polymorphic_allocator<int>> l({ 1, 2, 3 }, &a1);
+  TXorList<int, std::pmr::polymorphic_allocator<int>> m({ 9 }, &a2);
+
+  m = std::move(l);
+
+  EXPECT_EQ(&a2, m.get_allocator().resource());
+  EXPECT_TRUE(l.empty());
+  EXPECT_EQ((std::vector<int>{ 1, 2, 3 }), std::vector<int>(m.begin(), m.end()));
+  EXPECT_EQ((std::vector<int>{ 3, 2, 1 }), std::vector<int>(m.rbegin(), m.rend()));
+}
+
+TEST(TXorList, frees_every_node)
+{
+  TAllocStats stats;
+  {
+    TXorList<int, TCountingAllocator<int>> l{ TCountingAllocator<int>(&stats) };
+    for (int i = 0; i < 100; i++)
+      l.push_back(i);
+    for (auto it = l.begin(); it != l.end();)
+      it = *it % 3 == 0 ? l.erase(it) : std::next(it);
+
+    EXPECT_EQ(66u, stats.live);
+    EXPECT_EQ(sizeof(TListNode<int>) - sizeof(void*), stats.lastSize);
+  }
+
+  EXPECT_EQ(stats.allocs, stats.frees);
+}
@@ -0,0 +1,176 @@
+#include "gtest.h"
+#include "tlru.h"
+
+#include <string>
+#include <vector>
+
+namespace
+{
+  template <class C>
+  std::vector<int> Keys(const C& c)
+  {
+    std::vector<int> keys;
+    for (const auto& e : c)
+      keys.push_back(e.key);
+    return keys;
+  }
+
+  // Weighs a string value by its length.
+  struct TLengthWeight
+  {
+    size_t operator()(int, const std::string& s) const { return s.size(); }
+  };
+}
+
+TEST(TLruCache, rejects_zero_capacity)
+{
+  ASSERT_THROW((TLruCache<int, int>(0)), std::invalid_argument);
+}
+
+TEST(TLruCache, can_put_and_get)
+{
+  TLruCache<int, std::string> c(4);
+
+  c.put(1, "one");
+  c.put(2, "two");
+
+  ASSERT_NE(nullptr, c.get(1));
+  EXPECT_EQ("one", *c.get(1));
+  EXPECT_EQ(nullptr, c.get(3));
+  EXPECT_EQ(2u, c.size());
+}
+
+TEST(TLruCache, evicts_least_recently_used_by_count)
+{
+  TLruCache<int, int> c(3);
+  c.put(1, 10);
+  c.put(2, 20);
+  c.put(3, 30);
+
+  c.get(1);
+  c.put(4, 40);
+
+  EXPECT_FALSE(c.contains(2));
+  EXPECT_EQ(std::vector<int>({ 4, 1, 3 }), Keys(c));
+  EXPECT_EQ(1u, c.evictions());
+}
+
+TEST(TLruCache, put_replaces_and_refreshes)
+{
+  TLruCache<int, int> c(2);
+  c.put(1, 10);
+  c.put(2, 20);
+
+  c.put(1, 11);
+  c.put(3, 30);
+
+  EXPECT_EQ(11, *c.peek(1));
+  EXPECT_FALSE(c.contains(2));
+  EXPECT_EQ(2u, c.size());
+}
+
+TEST(TLruCache, peek_does_not_touch_order_or_counters)
+{
+  TLruCache<int, int> c(2);
+  c.put(1, 10);
+  c.put(2, 20);
+
+  EXPECT_EQ(10, *c.peek(1));
+  c.put(3, 30);
+
+  EXPECT_EQ(nullptr, c.peek(1));
+  EXPECT_EQ(0u, c.hits() + c.misses());
+}
+
+TEST(TLruCache, evicts_by_weight)
+{
+  TLruCache<int, std::string, std::hash<int>, std::equal_to<int>, TLengthWeight> c(100, 10);
+  c.put(1, "aaaa");
+  c.put(2, "bbbb");
+
+  c.put(3, "cccc");
+  EXPECT_EQ(std::vector<int>({ 3, 2 }), Keys(c));
+  EXPECT_EQ(8u, c.weight());
+
+  c.put(2, "bbbbbb");
+  EXPECT_EQ(std::vector<int>({ 2, 3 }), Keys(c));
+  EXPECT_EQ(10u, c.weight());
+}
+
+TEST(TLruCache, drops_an_entry_heavier_than_the_limit)
+{
+  TLruCache<int, std::string, std::hash<int>, std::equal_to<int>, TLengthWeight> c(100, 5);
+  c.put(1, "aa");
+  c.put(2, "bb");
+
+  EXPECT_FALSE(c.put(3, "cccccc"));
+  EXPECT_FALSE(c.put(1, "aaaaaa"));
+
+  EXPECT_EQ(std::vector<int>({ 2 }), Keys(c));
+  EXPECT_EQ(2u, c.weight());
+}
+
+TEST(TLruCache, counts_hits_and_misses)
+{
+  TLruCache<int, int> c(8);
+  c.put(1, 1);
+
+  c.get(1);
+  c.get(1);
+  c.get(2);
+
+  EXPECT_EQ(2u, c.hits());
+  EXPECT_EQ(1u, c.misses());
+  EXPECT_DOUBLE_EQ(2.0 / 3.0, c.hit_ratio());
+
+  c.reset_stats();
+  EXPECT_EQ(0u, c.hits() + c.misses());
+}
+
+TEST(TLruCache, shrinking_capacity_evicts_oldest)
+{
+  TLruCache<int, int> c(10);
+  for (int i = 0; i < 10; i++)
+    c.put(i, i);
+
+  c.set_capacity(3);
+
+  EXPECT_EQ(std::vector<int>({ 9, 8, 7 }), Keys(c));
+  EXPECT_EQ(7u, c.evictions());
+}
+
+TEST(TLruCache, can_erase_and_clear)
+{
+  TLruCache<int, int> c(10);
+  for (int i = 0; i < 5; i++)
+    c.put(i, i);
+
+  EXPECT_TRUE(c.erase(2));
+  EXPECT_FALSE(c.erase(2));
+  EXPECT_EQ(4u, c.size());
+
+  c.clear();
+  EXPECT_TRUE(c.empty());
+  EXPECT_EQ(0u, c.weight());
+  c.put(2, 2);
+  EXPECT_EQ(2, *c.get(2));
+}
+
+TEST(TLruCache, stays_consistent_under_churn)
+{
+  TLruCache<int, int> c(64);
+  for (int i = 0; i < 10000; i++)
+  {
+    int k = (i * 7919) % 257;
+    if (int* v = c.get(k))
+      EXPECT_EQ(k, *v);
+    else
+      c.put(k, k);
+    if (i % 5 == 0)
+      c.erase((k + 1) % 257);
+  }
+
+  EXPECT_GE(64u, c.size());
+  for (const auto& e : c)
+    EXPECT_EQ(e.key, e.value);
+}